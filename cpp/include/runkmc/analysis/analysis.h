@@ -1,32 +1,31 @@
 #pragma once
+#include <atomic>
+#include <thread>
+
 #include "common.h"
+#include "kmc/config.h"
 #include "kmc/state.h"
 #include "analysis/utils.h"
 
 namespace analysis
 {
-    void analyzeChainLengthDist(Eigen::MatrixXd &sequenceStatsMatrix, const std::vector<double> &monomerFWs, AnalysisState &state)
+    // Chain length and molecular weight averages from the moments of all chains
+    void analyzeChainLengthDist(const ChainMoments &moments, const std::vector<double> &monomerFWs, AnalysisState &state)
     {
-        if (sequenceStatsMatrix.rows() == 0 || sequenceStatsMatrix.cols() == 0)
+        if (moments.numChains == 0 || registry::NUM_MONOMERS == 0)
             return;
+        const double numChains = double(moments.numChains);
 
-        // SequenceStatsMatrix: (numPolymers x (A Count, B Count, ..., A SeqCount, B SeqCount, ..., A SeqLen2, B SeqLen2, ...))
-        // Extract monomer count distribution (shape: numPolymers x numMonomers)
-        Eigen::MatrixXd monomerCountDist = sequenceStatsMatrix.leftCols(registry::NUM_MONOMERS);
-
-        // Chain length calculations (Get chain lengths by summing monomer counts)
-        Eigen::VectorXd chainLengths = monomerCountDist.rowwise().sum();
-        state.nAvgCL = chainLengths.mean();
+        state.nAvgCL = double(moments.sumLength()) / numChains;
         if (state.nAvgCL != 0.0)
         {
-            state.wAvgCL = chainLengths.array().square().mean() / state.nAvgCL;
+            state.wAvgCL = double(moments.sumLength2()) / numChains / state.nAvgCL;
             state.dispCL = state.wAvgCL / state.nAvgCL;
         }
 
         // If any monomer has FW of 0, skip molecular weight calculations
         // and set molecular weight averages to chain length averages
-        Eigen::VectorXd FWs = Eigen::Map<const Eigen::VectorXd>(monomerFWs.data(), monomerFWs.size());
-        if ((FWs.array() == 0.0).any())
+        if (std::find(monomerFWs.begin(), monomerFWs.end(), 0.0) != monomerFWs.end())
         {
             state.nAvgMW = state.nAvgCL;
             state.wAvgMW = state.wAvgCL;
@@ -34,33 +33,46 @@ namespace analysis
             return;
         }
 
-        // Molecular weight calculations
-        Eigen::MatrixXd weightedMonomerCountDist = monomerCountDist.array().rowwise() * FWs.transpose().array();
-        Eigen::VectorXd molecularWeights = weightedMonomerCountDist.rowwise().sum();
-        state.nAvgMW = molecularWeights.mean();
+        state.nAvgMW = moments.sumFirstMoment(monomerFWs) / numChains;
         if (state.nAvgMW != 0.0)
         {
-            state.wAvgMW = molecularWeights.array().square().mean() / state.nAvgMW;
+            state.wAvgMW = moments.sumSecondMoment(monomerFWs) / numChains / state.nAvgMW;
             state.dispMW = state.wAvgMW / state.nAvgMW;
         }
     }
 
-    // SequenceStatsMatrix: (numPolymers x (A Count, B Count, ..., A SeqCount, B SeqCount, ..., A SeqLen2, B SeqLen2, ...))
-    void analyzeSequenceLengthDist(Eigen::MatrixXd &sequenceStatsMatrix, AnalysisState &state)
+    // Warns if the live moments differ from the full pass (moments = validate)
+    // The moments are integers, so any difference is a bookkeeping error rather than rounding
+    void validateChainMoments(const ChainMoments &live, const ChainMoments &full, double kmcTime)
     {
+        if (!(live == full))
+        {
+            console::warning(
+                "Live chain moments differ from the full pass at t = " + std::to_string(kmcTime) +
+                ": chains " + std::to_string(live.numChains) + " vs " + std::to_string(full.numChains) +
+                ", sum L " + std::to_string(live.sumLength()) + " vs " + std::to_string(full.sumLength()) +
+                ", sum L^2 " + std::to_string(live.sumLength2()) + " vs " + std::to_string(full.sumLength2()) + ".");
+        }
+    }
 
-        if (sequenceStatsMatrix.rows() == 0 || sequenceStatsMatrix.cols() < SequenceStats::SIZE())
+    // positionalStats: stats of all chains (folded chains included), summed over chains
+    void analyzeSequenceLengthDist(const PositionalStats &positionalStats, AnalysisState &state)
+    {
+        if (positionalStats.empty() || PositionalStats::SIZE() == 0)
             return;
 
-        // Sum stats over all polymers -> (1 x (Total A Count, B Count, ..., A SeqCount, B SeqCount, ..., A SeqLen2, B SeqLen2, ...))
-        auto totalStats = sequenceStatsMatrix.colwise().sum();
-        auto totalMonomerCounts = totalStats.leftCols(registry::NUM_MONOMERS).sum(); // Total chain length (i.e. total monomer count across all types)
+        // Sum stats over all buckets -> (Total A Count, B Count, ..., A SeqCount, B SeqCount, ..., A SeqLen2, B SeqLen2, ...)
+        std::vector<uint64_t> totalStats(PositionalStats::SIZE());
+        kernels::selected.sumBuckets(positionalStats, totalStats.data());
+        double totalMonomerCounts = 0; // Total chain length (i.e. total monomer count across all types)
+        for (size_t i = 0; i < registry::NUM_MONOMERS; ++i)
+            totalMonomerCounts += double(totalStats[i]);
 
         for (size_t i = 0; i < registry::NUM_MONOMERS; ++i)
         {
-            auto monomerCounts = totalStats(0 * registry::NUM_MONOMERS + i);    // Total count of monomer type i across all polymers
-            auto sequenceCounts = totalStats(1 * registry::NUM_MONOMERS + i);   // Total number of sequences of monomer type i across all polymers
-            auto sequenceLengths2 = totalStats(2 * registry::NUM_MONOMERS + i); // Sum of squared sequence lengths of monomer type i across all polymers
+            double monomerCounts = double(totalStats[0 * registry::NUM_MONOMERS + i]);    // Total count of monomer type i across all polymers
+            double sequenceCounts = double(totalStats[1 * registry::NUM_MONOMERS + i]);   // Total number of sequences of monomer type i across all polymers
+            double sequenceLengths2 = double(totalStats[2 * registry::NUM_MONOMERS + i]); // Sum of squared sequence lengths of monomer type i across all polymers
 
             if (sequenceCounts > 0 && monomerCounts > 0)
             {
@@ -72,18 +84,236 @@ namespace analysis
         }
     }
 
-    void analyze(const SpeciesSet &speciesSet, SystemState &systemState)
+    static constexpr size_t ANALYSIS_CHUNK_SIZE = 4096; // Chains per work item of the analysis pass
+
+    // Threads worth starting for numChunks chunks (at least one)
+    static size_t getNumWorkers(size_t numThreads, size_t numChunks)
     {
-        auto sequenceData = speciesSet.getRawSequenceData();
-        auto summary = analysis::calculateSequenceSummary(sequenceData);
+        return std::max(size_t(1), std::min(numThreads, numChunks));
+    }
+
+    /**
+     * @brief Calls work(worker, chunk) for every chunk in [0, numChunks). The chunks are handed out
+     * through an atomic counter to numWorkers threads, the calling thread being worker 0. Each
+     * worker accumulates into its own results, which the caller sums in worker order.
+     */
+    template <typename Work>
+    void forEachChunk(size_t numChunks, size_t numWorkers, const Work &work)
+    {
+        std::atomic<size_t> nextChunk(0);
+        auto worker = [&](size_t workerIndex)
+        {
+            for (size_t c = nextChunk++; c < numChunks; c = nextChunk++)
+                work(workerIndex, c);
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t workerIndex = 1; workerIndex < numWorkers; ++workerIndex)
+            threads.emplace_back(worker, workerIndex);
+        worker(0);
+        for (auto &thread : threads)
+            thread.join();
+    }
+
+    /**
+     * @brief One streaming pass over the chains of every PolymerType. Each chain's positional
+     * stats are added straight into the summary, read in place from its packed sequence. With
+     * computeMoments the chain moments are also recomputed from each chain's stats (moments = full
+     * or validate), through one reused per-chain scratch. Memory does not grow with the number of chains.
+     *
+     * The chains are split into fixed chunks of ANALYSIS_CHUNK_SIZE chains of one type, handed
+     * out to numThreads threads. Positional stats and moments are integer sums, so each thread
+     * keeps its own and the results do not depend on the number of threads.
+     */
+    SequenceSummary summarizeChains(const SpeciesSet &speciesSet, bool computeMoments, size_t numThreads)
+    {
+        struct Chunk
+        {
+            const std::vector<PolymerHandle> *handles;
+            size_t begin;
+            size_t end;
+        };
+        std::vector<Chunk> chunks;
+        for (const auto &polymerType : speciesSet.getPolymerTypes())
+        {
+            const auto &handles = polymerType.getPolymers();
+            for (size_t begin = 0; begin < handles.size(); begin += ANALYSIS_CHUNK_SIZE)
+                chunks.push_back(Chunk{&handles, begin, std::min(handles.size(), begin + ANALYSIS_CHUNK_SIZE)});
+        }
+
+        const size_t numWorkers = getNumWorkers(numThreads, chunks.size());
+        std::vector<PositionalStats> workerStats(numWorkers, PositionalStats(NUM_BUCKETS));
+        std::vector<ChainMoments> workerMoments(numWorkers);
+        std::vector<PositionalStats> workerChainStats(computeMoments ? numWorkers : 0, PositionalStats(NUM_BUCKETS));
+        std::vector<std::vector<uint64_t>> workerRows(computeMoments ? numWorkers : 0, std::vector<uint64_t>(PositionalStats::SIZE()));
+        const PolymerPool *polymerPool = speciesSet.getPolymerPool();
+
+        forEachChunk(
+            chunks.size(), numWorkers,
+            [&](size_t worker, size_t c)
+            {
+                PositionalStats &stats = workerStats[worker];
+                const Chunk &chunk = chunks[c];
+                for (size_t i = chunk.begin; i < chunk.end; ++i)
+                {
+                    const Polymer &polymer = *polymerPool->get((*chunk.handles)[i]);
+                    if (!computeMoments)
+                    {
+                        polymer.addPositionalStats(stats);
+                        continue;
+                    }
+
+                    PositionalStats &chainStats = workerChainStats[worker];
+                    chainStats.clear();
+                    polymer.addPositionalStats(chainStats);
+                    stats += chainStats;
+
+                    // Monomer counts of the chain are the first NUM_MONOMERS values of its summed row
+                    std::vector<uint64_t> &row = workerRows[worker];
+                    kernels::selected.sumBuckets(chainStats, row.data());
+                    workerMoments[worker].add(row.data());
+                }
+            });
+
+        SequenceSummary summary{PositionalStats(NUM_BUCKETS), ChainMoments()};
+        for (const auto &stats : workerStats)
+            summary.positionalStats += stats;
+        for (const auto &moments : workerMoments)
+            summary.moments += moments;
+        return summary;
+    }
+
+    void analyze(const SpeciesSet &speciesSet, SystemState &systemState, config::MomentMode momentMode, size_t numThreads = 1)
+    {
+        const auto monomerFWs = speciesSet.getMonomerFWs();
+        const bool fullPass = momentMode != config::MomentMode::LIVE;
+        auto summary = analysis::summarizeChains(speciesSet, fullPass, numThreads);
+
+        // Dead chains folded into running aggregates (dead_chains = stream)
+        auto foldedChains = speciesSet.getFoldedChains();
+        if (!foldedChains.empty())
+            summary.positionalStats += foldedChains.positionalStats;
 
         SequenceState sequenceState = SequenceState{systemState.kmc, summary.positionalStats};
 
+        ChainMoments moments = speciesSet.getChainMoments();
+        if (fullPass)
+        {
+            ChainMoments fullMoments = summary.moments;
+            fullMoments += foldedChains.moments;
+            if (momentMode == config::MomentMode::VALIDATE)
+                analysis::validateChainMoments(moments, fullMoments, systemState.kmc.kmcTime);
+            moments = fullMoments;
+        }
+
         AnalysisState analysisState;
-        analysis::analyzeChainLengthDist(summary.sequenceStatsMatrix, speciesSet.getMonomerFWs(), analysisState);
-        analysis::analyzeSequenceLengthDist(summary.sequenceStatsMatrix, analysisState);
+        analysis::analyzeChainLengthDist(moments, monomerFWs, analysisState);
+        analysis::analyzeSequenceLengthDist(summary.positionalStats, analysisState);
 
         systemState.sequence = sequenceState;
         systemState.analysis = analysisState;
     }
+
+    /**
+     * @brief Copy of everything analyze needs (with moments = live), so that the analysis can run
+     * on another thread while the simulation goes on. Compressed and folded chains only add their
+     * summed stats; the packed words of every other chain are copied into one block.
+     */
+    struct AnalysisSnapshot
+    {
+        struct Chain
+        {
+            size_t offset;          // First word of the chain in words
+            uint32_t length;        // Units of the head
+            uint32_t coupledLength; // Units of the second half, whose words follow the head
+        };
+
+        SystemState systemState;
+        std::vector<double> monomerFWs;
+        ChainMoments moments;
+        PositionalStats positionalStats; // Compressed and folded chains
+        std::vector<SequenceWord> words;
+        std::vector<Chain> chains;
+
+        static size_t getNumWords(size_t length)
+        {
+            const size_t unitsPerWord = registry::SEQUENCE_CODEC.unitsPerWord;
+            return (length + unitsPerWord - 1) / unitsPerWord;
+        }
+    };
+
+    AnalysisSnapshot takeSnapshot(const SpeciesSet &speciesSet, const SystemState &systemState)
+    {
+        AnalysisSnapshot snapshot;
+        snapshot.systemState = systemState;
+        snapshot.monomerFWs = speciesSet.getMonomerFWs();
+        snapshot.moments = speciesSet.getChainMoments();
+        snapshot.positionalStats = speciesSet.getCompressedStats();
+
+        // Dead chains folded into running aggregates (dead_chains = stream)
+        auto foldedChains = speciesSet.getFoldedChains();
+        if (!foldedChains.empty())
+            snapshot.positionalStats += foldedChains.positionalStats;
+
+        auto copyWords = [&](const SequenceBuffer &sequence)
+        {
+            const SequenceWord *words = sequence.getWords();
+            snapshot.words.insert(snapshot.words.end(), words, words + AnalysisSnapshot::getNumWords(sequence.size()));
+        };
+
+        speciesSet.forEachPolymer(
+            [&](const Polymer &polymer)
+            {
+                if (polymer.isCompressed())
+                    return;
+                const Polymer *coupled = polymer.getCoupled();
+                snapshot.chains.push_back(AnalysisSnapshot::Chain{
+                    snapshot.words.size(),
+                    uint32_t(polymer.getSequence().size()),
+                    uint32_t(coupled ? coupled->getSequence().size() : 0)});
+                copyWords(polymer.getSequence());
+                if (coupled)
+                    copyWords(coupled->getSequence());
+            });
+
+        return snapshot;
+    }
+
+    /**
+     * @brief Same results as analyze with moments = live, computed from a snapshot. The chains are
+     * split into chunks of ANALYSIS_CHUNK_SIZE and summed on numThreads threads as in summarizeChains.
+     */
+    SystemState analyzeSnapshot(const AnalysisSnapshot &snapshot, size_t numThreads = 1)
+    {
+        const size_t numChunks = (snapshot.chains.size() + ANALYSIS_CHUNK_SIZE - 1) / ANALYSIS_CHUNK_SIZE;
+        const size_t numWorkers = getNumWorkers(numThreads, numChunks);
+        std::vector<PositionalStats> workerStats(numWorkers, PositionalStats(NUM_BUCKETS));
+
+        forEachChunk(
+            numChunks, numWorkers,
+            [&](size_t worker, size_t c)
+            {
+                const size_t end = std::min(snapshot.chains.size(), (c + 1) * ANALYSIS_CHUNK_SIZE);
+                for (size_t i = c * ANALYSIS_CHUNK_SIZE; i < end; ++i)
+                {
+                    const auto &chain = snapshot.chains[i];
+                    const SequenceWord *head = snapshot.words.data() + chain.offset;
+                    const SequenceWord *tail = head + AnalysisSnapshot::getNumWords(chain.length);
+                    analysis::addPositionalSequenceStats(head, chain.length, tail, chain.coupledLength, workerStats[worker]);
+                }
+            });
+
+        PositionalStats positionalStats = snapshot.positionalStats;
+        for (const auto &stats : workerStats)
+            positionalStats += stats;
+
+        SystemState systemState = snapshot.systemState;
+        systemState.sequence = SequenceState{systemState.kmc, positionalStats};
+
+        AnalysisState analysisState;
+        analysis::analyzeChainLengthDist(snapshot.moments, snapshot.monomerFWs, analysisState);
+        analysis::analyzeSequenceLengthDist(positionalStats, analysisState);
+        systemState.analysis = analysisState;
+        return systemState;
+    }
 }
@@ -1,73 +1,212 @@
 #pragma once
-#include <Eigen/Core>
+#include <numeric>
 
 #include "common.h"
 
 namespace analysis
 {
-    struct SequenceStats
+    /**
+     * @brief Sequence statistics of one or more chains, divided into positional buckets.
+     * All values live in one flat array, bucket after bucket. Each bucket is a row of SIZE()
+     * values in the order
+     *     MonCounts_A, MonCounts_B, ..., SeqCounts_A, SeqCounts_B, ..., SeqLengths2_A, SeqLengths2_B, ...
+     */
+    class PositionalStats
     {
-        std::vector<uint64_t> monCounts;
-        std::vector<uint64_t> seqCounts;
-        std::vector<uint64_t> seqLengths2;
-
+    public:
         const static size_t NUM_METRICS = 3;
+        enum Metric
+        {
+            MON_COUNTS = 0,
+            SEQ_COUNTS = 1,
+            SEQ_LENGTHS2 = 2,
+        };
+
+        PositionalStats() {};
+
+        PositionalStats(size_t numBuckets_) : numBuckets(numBuckets_), values(numBuckets_ * SIZE(), 0) {};
 
-        SequenceStats()
+        // Values per bucket
+        static size_t SIZE() { return registry::NUM_MONOMERS * NUM_METRICS; }
+
+        size_t getNumBuckets() const { return numBuckets; }
+        bool empty() const { return numBuckets == 0; }
+
+        uint64_t get(size_t bucket, Metric metric, size_t monomer) const
         {
-            monCounts.resize(registry::NUM_MONOMERS, 0);
-            seqCounts.resize(registry::NUM_MONOMERS, 0);
-            seqLengths2.resize(registry::NUM_MONOMERS, 0);
+            return values[bucket * SIZE() + metric * registry::NUM_MONOMERS + monomer];
         }
 
-        static size_t SIZE() { return registry::NUM_MONOMERS * NUM_METRICS; }
+        void clear() { std::fill(values.begin(), values.end(), 0); }
 
-        SequenceStats &operator+=(const SequenceStats &other)
+        uint64_t *data() { return values.data(); }
+        const uint64_t *data() const { return values.data(); }
+
+        PositionalStats &operator+=(const PositionalStats &other)
         {
-            for (size_t i = 0; i < registry::NUM_MONOMERS; ++i)
-            {
-                monCounts[i] += other.monCounts[i];
-                seqCounts[i] += other.seqCounts[i];
-                seqLengths2[i] += other.seqLengths2[i];
-            }
+            uint64_t *__restrict lhs = values.data();
+            const uint64_t *__restrict rhs = other.values.data();
+            for (size_t i = 0; i < values.size(); ++i)
+                lhs[i] += rhs[i];
             return *this;
         }
 
-        /*
-        MonCounts_A, MonCounts_B, ...,
-        SeqCounts_A, SeqCounts_B, ...,
-        SeqLengths2_A, SeqLengths2_B, ...
-        */
-        Eigen::VectorXd toEigen() const
+        PositionalStats &operator-=(const PositionalStats &other)
         {
-            Eigen::VectorXd result(SIZE());
-            for (size_t i = 0; i < registry::NUM_MONOMERS; ++i)
-                result(0 * registry::NUM_MONOMERS + i) = static_cast<double>(monCounts[i]);
-            for (size_t i = 0; i < registry::NUM_MONOMERS; ++i)
-                result(1 * registry::NUM_MONOMERS + i) = static_cast<double>(seqCounts[i]);
-            for (size_t i = 0; i < registry::NUM_MONOMERS; ++i)
-                result(2 * registry::NUM_MONOMERS + i) = static_cast<double>(seqLengths2[i]);
-            return result;
+            uint64_t *__restrict lhs = values.data();
+            const uint64_t *__restrict rhs = other.values.data();
+            for (size_t i = 0; i < values.size(); ++i)
+                lhs[i] -= rhs[i];
+            return *this;
         }
+
+    private:
+        size_t numBuckets = 0;
+        std::vector<uint64_t> values;
     };
 
-    struct SequenceSummary
+    /**
+     * @brief Zeroth, first and second moments of the monomer counts of a set of chains: the number
+     * of chains, the sum over chains of every count c_i and of every product c_i * c_j. They are
+     * integers, so chains can be added and removed any number of times without drift, and they give
+     * the chain length (weights 1) and molecular weight (weights FW) moments for any weights.
+     * Each PolymerType keeps the moments of its chains up to date as chains are inserted and
+     * removed, so the averages never need a pass over the chains.
+     */
+    struct ChainMoments
     {
-        Eigen::MatrixXd sequenceStatsMatrix;        // (polymers x (SequenceStats))
-        std::vector<SequenceStats> positionalStats; // (buckets x (monomers*fields))
+        uint64_t numChains = 0;
+        std::vector<uint64_t> monomerCounts;   // sum over chains of c_i
+        std::vector<uint64_t> monomerProducts; // sum over chains of c_i * c_j (row-major, NUM_MONOMERS^2)
+
+        bool empty() const { return numChains == 0; }
+
+        // counts: the NUM_MONOMERS monomer counts of one chain
+        template <typename T>
+        void add(const T *counts)
+        {
+            if (monomerCounts.empty())
+                resize();
+            ++numChains;
+            update<1>(counts);
+        }
+
+        template <typename T>
+        void remove(const T *counts)
+        {
+            --numChains;
+            update<-1>(counts);
+        }
+
+        ChainMoments &operator+=(const ChainMoments &other)
+        {
+            if (other.monomerCounts.empty())
+                return *this;
+            if (monomerCounts.empty())
+                return *this = other;
+
+            numChains += other.numChains;
+            for (size_t i = 0; i < monomerCounts.size(); ++i)
+                monomerCounts[i] += other.monomerCounts[i];
+            for (size_t i = 0; i < monomerProducts.size(); ++i)
+                monomerProducts[i] += other.monomerProducts[i];
+            return *this;
+        }
+
+        bool operator==(const ChainMoments &other) const
+        {
+            return numChains == other.numChains &&
+                   (numChains == 0 || (monomerCounts == other.monomerCounts && monomerProducts == other.monomerProducts));
+        }
+
+        // Sum over chains of L and of L^2 (L = sum_i c_i)
+        uint64_t sumLength() const { return std::accumulate(monomerCounts.begin(), monomerCounts.end(), uint64_t(0)); }
+        uint64_t sumLength2() const { return std::accumulate(monomerProducts.begin(), monomerProducts.end(), uint64_t(0)); }
+
+        // Sum over chains of (sum_i w_i c_i), e.g. the total mass for w = FW
+        double sumFirstMoment(const std::vector<double> &weights) const
+        {
+            double sum = 0;
+            for (size_t i = 0; i < monomerCounts.size(); ++i)
+                sum += weights[i] * double(monomerCounts[i]);
+            return sum;
+        }
+
+        // Sum over chains of (sum_i w_i c_i)^2
+        double sumSecondMoment(const std::vector<double> &weights) const
+        {
+            double sum = 0;
+            for (size_t i = 0; i < monomerCounts.size(); ++i)
+                for (size_t j = 0; j < monomerCounts.size(); ++j)
+                    sum += weights[i] * weights[j] * double(monomerProducts[i * monomerCounts.size() + j]);
+            return sum;
+        }
+
+    private:
+        void resize()
+        {
+            monomerCounts.assign(registry::NUM_MONOMERS, 0);
+            monomerProducts.assign(registry::NUM_MONOMERS * registry::NUM_MONOMERS, 0);
+        }
+
+        // SIGN = -1 subtracts through unsigned wrap-around
+        template <int SIGN, typename T>
+        void update(const T *counts)
+        {
+            const size_t numMonomers = monomerCounts.size();
+            for (size_t i = 0; i < numMonomers; ++i)
+            {
+                if (counts[i] == 0)
+                    continue;
+                monomerCounts[i] += SIGN * uint64_t(counts[i]);
+                for (size_t j = 0; j < numMonomers; ++j)
+                    monomerProducts[i * numMonomers + j] += SIGN * (uint64_t(counts[i]) * uint64_t(counts[j]));
+            }
+        }
     };
 
-    struct RawSequenceData
+    /**
+     * @brief Running sums over a set of chains. They hold everything analysis::analyze needs from
+     * those chains, so the chains themselves do not have to be kept:
+     * the moments of their monomer counts and their summed positional stats.
+     */
+    struct ChainAggregate
     {
-        std::vector<std::vector<SpeciesID>> sequences;
-        std::vector<std::vector<SequenceStats>> precomputedStats;
-        size_t length;
+        ChainMoments moments;
+        PositionalStats positionalStats; // (buckets x (monomers*fields))
+
+        ChainAggregate() {};
+
+        ChainAggregate(size_t numBuckets)
+        {
+            positionalStats = PositionalStats(numBuckets);
+            row.resize(PositionalStats::SIZE(), 0);
+        }
+
+        bool empty() const { return moments.empty(); }
+
+        // Defined in analysis/utils.h, after the kernels it uses
+        void addChain(const PositionalStats &chainStats);
 
-        RawSequenceData(size_t n)
+        ChainAggregate &operator+=(const ChainAggregate &other)
         {
-            sequences.reserve(n);
-            precomputedStats.reserve(n);
-            length = n;
+            if (other.empty())
+                return *this;
+            if (positionalStats.empty())
+                return *this = other;
+
+            moments += other.moments;
+            positionalStats += other.positionalStats;
+            return *this;
         }
+
+    private:
+        std::vector<uint64_t> row; // Scratch for addChain (SIZE() values)
+    };
+
+    struct SequenceSummary
+    {
+        PositionalStats positionalStats; // (buckets x (monomers*fields)), summed over polymers
+        ChainMoments moments;            // Recomputed from the chains (full pass only)
     };
 }
\ No newline at end of file
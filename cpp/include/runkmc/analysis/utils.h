@@ -1,6 +1,9 @@
 #pragma once
+#include <array>
+
 #include "common.h"
 #include "analysis/types.h"
+#include "species/sequence_arena.h"
 
 namespace analysis
 {
@@ -16,99 +19,346 @@ namespace analysis
         return (bucket == numBuckets) ? numBuckets - 1 : bucket;
     }
 
-    // Calculate sequence statistics for a single polymer sequence, divided into buckets
-    std::vector<SequenceStats> calculatePositionalSequenceStats(const std::vector<SpeciesID> &sequence, const size_t &numBuckets)
+    // Kernels templated on the number of monomers M. M = 0 is the generic version that reads
+    // registry::NUM_MONOMERS at run time; for M > 0 every per-monomer loop has a constant trip count.
+    namespace kernels
     {
-        std::vector<SequenceStats> stats(numBuckets);
-        if (sequence.empty())
-            return stats;
+        template <size_t M>
+        size_t numMonomers() { return M ? M : registry::NUM_MONOMERS; }
+
+        // Accumulates the stats of a sequence one unit at a time
+        template <size_t M>
+        struct UnitAccumulator
+        {
+            uint64_t *values;
+            const size_t numMonomers = kernels::numMonomers<M>();
+            const size_t rowSize = numMonomers * PositionalStats::NUM_METRICS;
+
+            uint64_t currentCode = 0;
+            size_t runLength = 0;
+            bool inSequence = false;
+
+            UnitAccumulator(PositionalStats &stats) : values(stats.data()) {};
+
+            uint64_t &at(size_t bucket, PositionalStats::Metric metric, size_t monomer)
+            {
+                return values[bucket * rowSize + metric * numMonomers + monomer];
+            }
+
+            void endRun(size_t bucket)
+            {
+                at(bucket, PositionalStats::SEQ_COUNTS, currentCode) += 1;
+                at(bucket, PositionalStats::SEQ_LENGTHS2, currentCode) += runLength * runLength;
+            }
+
+            // code must be a monomer code (= monomer index)
+            void addMonomer(uint64_t code, size_t bucket)
+            {
+                at(bucket, PositionalStats::MON_COUNTS, code)++;
+
+                if (inSequence && code == currentCode)
+                {
+                    runLength++;
+                }
+                else if (inSequence)
+                {
+                    endRun(bucket);
+                    runLength = 1;
+                }
+                else
+                {
+                    inSequence = true;
+                    runLength = 1;
+                }
+                currentCode = code;
+            }
+        };
 
-        SpeciesID currentMonomer = 0;
-        size_t currentSequenceLength = 0;
-        bool inSequence = false;
+        // Kernels add the stats of one chain to stats, bucketed by stats.getNumBuckets()
+        template <size_t M>
+        void sequenceStats(const std::vector<SpeciesID> &sequence, PositionalStats &stats)
+        {
+            const size_t numBuckets = stats.getNumBuckets();
+            if (sequence.empty())
+                return;
+
+            const auto &codec = registry::SEQUENCE_CODEC;
+            UnitAccumulator<M> accumulator(stats);
+            for (size_t i = 0; i < sequence.size(); ++i)
+            {
+                // Skip non-monomer units
+                uint64_t code = codec.encode(sequence[i]);
+                if (!codec.isMonomer(code))
+                    continue;
+                accumulator.addMonomer(code, getBucketIndex(i, sequence.size(), numBuckets));
+            }
+
+            // Add the stats for the last sequence
+            if (accumulator.inSequence)
+                accumulator.endRun(getBucketIndex(sequence.size() - 1, sequence.size(), numBuckets));
+        }
 
-        for (size_t i = 0; i < sequence.size(); ++i)
+        // Accumulates the stats of a bit-packed sequence a word (or a unit) at a time
+        template <size_t M>
+        struct PackedAccumulator
         {
-            size_t bucket = getBucketIndex(i, sequence.size(), numBuckets);
-            SpeciesID id = sequence[i];
+            const SequenceCodec &codec = registry::SEQUENCE_CODEC;
+            UnitAccumulator<M> units;
+            size_t length;
+            size_t numBuckets;
+            std::array<size_t, NUM_BUCKETS + 1> bucketStart; // First position of every bucket (numBuckets + 1 used)
+            size_t unitBucket = 0;                           // Bucket of the current unit
+            size_t runBucket = 0;                            // Bucket of the last run boundary
+
+            PackedAccumulator(PositionalStats &stats, size_t length_, size_t numBuckets_)
+                : units(stats), length(length_), numBuckets(numBuckets_)
+            {
+                assert(numBuckets <= NUM_BUCKETS);
+
+                // getBucketIndex is non-decreasing in position
+                bucketStart[0] = 0;
+                bucketStart[numBuckets] = length;
+                for (size_t b = 1; b < numBuckets; ++b)
+                {
+                    size_t position = std::min(length, (b * length + numBuckets - 1) / numBuckets);
+                    while (position > 0 && getBucketIndex(position - 1, length, numBuckets) >= b)
+                        --position;
+                    while (position < length && getBucketIndex(position, length, numBuckets) < b)
+                        ++position;
+                    bucketStart[b] = position;
+                }
+            }
+
+            size_t advance(size_t &bucket, size_t position)
+            {
+                while (bucketStart[bucket + 1] <= position)
+                    ++bucket;
+                return bucket;
+            }
+
+            // Adds numUnits units packed in the low fields of word, starting at position first
+            void addWord(SequenceWord word, size_t first, size_t numUnits)
+            {
+                const size_t bits = codec.bits;
+                const size_t unitsPerWord = codec.unitsPerWord;
+                const uint64_t validFields = (numUnits == unitsPerWord) ? codec.lowBits : codec.lowBits & ((uint64_t(1) << (numUnits * bits)) - 1);
 
-            // Skip non-monomer units
-            if (!registry::isType(id, SpeciesType::MONOMER))
-                continue;
+                uint64_t otherUnits = 0;
+                for (uint64_t code = codec.numMonomers; code < codec.numCodes; ++code)
+                    otherUnits |= codec.matchFields(word, code);
+
+                if (otherUnits & validFields)
+                {
+                    for (size_t j = 0; j < numUnits; ++j)
+                    {
+                        uint64_t code = (word >> (j * bits)) & codec.fieldMask;
+                        if (codec.isMonomer(code))
+                            units.addMonomer(code, advance(unitBucket, first + j));
+                    }
+                    return;
+                }
+
+                // Monomer counts, one popcount per (bucket, monomer) within the word
+                size_t position = first;
+                while (position < first + numUnits)
+                {
+                    size_t bucket = advance(unitBucket, position);
+                    size_t segmentEnd = std::min(first + numUnits, bucketStart[bucket + 1]);
+                    uint64_t segment = validFields;
+                    segment &= ~((uint64_t(1) << ((position - first) * bits)) - 1);
+                    if (segmentEnd < first + unitsPerWord)
+                        segment &= (uint64_t(1) << ((segmentEnd - first) * bits)) - 1;
+                    for (size_t code = 0; code < units.numMonomers; ++code)
+                        units.at(bucket, PositionalStats::MON_COUNTS, code) += __builtin_popcountll(codec.matchFields(word, code) & segment);
+                    position = segmentEnd;
+                }
 
-            size_t monomerIndex = registry::getIndex(id, SpeciesType::MONOMER);
-            stats[bucket].monCounts[monomerIndex]++;
+                // Run boundaries: fields that differ from the previous monomer
+                if (!units.inSequence)
+                {
+                    units.inSequence = true;
+                    units.currentCode = word & codec.fieldMask;
+                    units.runLength = 0;
+                }
+                uint64_t previous = (word << bits) | units.currentCode;
+                uint64_t boundaries = ~codec.zeroFields(word ^ previous) & validFields;
+                size_t runStart = 0;
+                while (boundaries)
+                {
+                    size_t j = __builtin_ctzll(boundaries) / bits;
+                    units.runLength += j - runStart;
+                    units.endRun(advance(runBucket, first + j));
+                    units.currentCode = (word >> (j * bits)) & codec.fieldMask;
+                    units.runLength = 0;
+                    runStart = j;
+                    boundaries &= boundaries - 1;
+                }
+                units.runLength += numUnits - runStart;
+            }
 
-            if (id == currentMonomer)
+            // Adds the `size` units packed in words (see SequenceBuffer::getWords)
+            void addSequence(const SequenceWord *words, size_t size, size_t first)
             {
-                currentSequenceLength++;
+                for (size_t i = 0; i < size; i += codec.unitsPerWord)
+                    addWord(words[i / codec.unitsPerWord], first + i, std::min(codec.unitsPerWord, size - i));
             }
-            else if (inSequence)
+
+            // Adds the units of sequence in reverse order, still a word at a time
+            void addReversedSequence(const SequenceWord *words, size_t size, size_t first)
             {
-                size_t prevIndex = registry::getIndex(currentMonomer, SpeciesType::MONOMER);
-                stats[bucket].seqCounts[prevIndex] += 1;
-                stats[bucket].seqLengths2[prevIndex] += currentSequenceLength * currentSequenceLength;
-                currentSequenceLength = 1;
+                const size_t bits = codec.bits;
+                const size_t unitsPerWord = codec.unitsPerWord;
+                for (size_t i = 0; i < size; i += unitsPerWord)
+                {
+                    // Window of unitsPerWord units of sequence ending at `last`, reversed
+                    const size_t last = size - 1 - i;
+                    const size_t numUnits = std::min(unitsPerWord, last + 1);
+                    SequenceWord window;
+                    if (numUnits == unitsPerWord)
+                    {
+                        size_t offset = (last + 1 - unitsPerWord) * bits;
+                        size_t shift = offset % SequenceCodec::WORD_BITS;
+                        window = words[offset / SequenceCodec::WORD_BITS] >> shift;
+                        if (shift != 0)
+                            window |= words[offset / SequenceCodec::WORD_BITS + 1] << (SequenceCodec::WORD_BITS - shift);
+                    }
+                    else
+                        window = words[0] << ((unitsPerWord - numUnits) * bits);
+                    addWord(codec.reverseFields(window), first + i, numUnits);
+                }
             }
-            else
+
+            void finish()
             {
-                inSequence = true;
-                currentSequenceLength = 1;
+                // Add the stats for the last sequence
+                if (units.inSequence)
+                    units.endRun(getBucketIndex(length - 1, length, numBuckets));
             }
+        };
+
+        // Stats of the headSize units of head followed by the tailSize units of tail in reverse
+        template <size_t M>
+        void packedSequenceStats(const SequenceWord *head, size_t headSize, const SequenceWord *tail, size_t tailSize, PositionalStats &stats)
+        {
+            const size_t length = headSize + tailSize;
+            if (length == 0)
+                return;
+
+            PackedAccumulator<M> accumulator(stats, length, stats.getNumBuckets());
+            accumulator.addSequence(head, headSize, 0);
+            if (tailSize > 0)
+                accumulator.addReversedSequence(tail, tailSize, headSize);
+            accumulator.finish();
+        }
 
-            currentMonomer = id;
+        // Sums the buckets of stats into row (SIZE() values)
+        template <size_t M>
+        void sumBuckets(const PositionalStats &stats, uint64_t *row)
+        {
+            const size_t rowSize = numMonomers<M>() * PositionalStats::NUM_METRICS;
+            const uint64_t *values = stats.data();
+            for (size_t i = 0; i < rowSize; ++i)
+                row[i] = 0;
+            for (size_t bucket = 0; bucket < stats.getNumBuckets(); ++bucket)
+                for (size_t i = 0; i < rowSize; ++i)
+                    row[i] += values[bucket * rowSize + i];
         }
 
-        // Add the stats for the last sequence
-        size_t bucket = getBucketIndex(sequence.size() - 1, sequence.size(), numBuckets);
-        size_t lastMonomerIdx = registry::getIndex(currentMonomer, SpeciesType::MONOMER);
-        stats[bucket].seqCounts[lastMonomerIdx] += 1;
-        stats[bucket].seqLengths2[lastMonomerIdx] += currentSequenceLength * currentSequenceLength;
+        struct KernelTable
+        {
+            void (*sequenceStats)(const std::vector<SpeciesID> &, PositionalStats &);
+            void (*packedSequenceStats)(const SequenceWord *, size_t, const SequenceWord *, size_t, PositionalStats &);
+            void (*sumBuckets)(const PositionalStats &, uint64_t *);
+        };
 
-        return stats;
+        template <size_t M>
+        KernelTable makeKernelTable() { return KernelTable{&sequenceStats<M>, &packedSequenceStats<M>, &sumBuckets<M>}; }
+
+        static KernelTable selected = makeKernelTable<0>();
     }
 
-    template <typename Func>
-    void forEachStats(const RawSequenceData &sequenceData, size_t numBuckets, Func callback)
+    /**
+     * @brief Chooses the analysis kernels for the number of monomers in the model (specialized for
+     * 1-4 monomers, generic otherwise). Called once after the registry is finalized.
+     */
+    static void selectKernels(size_t numMonomers)
     {
-        // Process sequences on-the-fly
-        auto numSequences = sequenceData.sequences.size();
-        for (size_t i = 0; i < numSequences; ++i)
+        switch (numMonomers)
         {
-            auto stats = calculatePositionalSequenceStats(sequenceData.sequences[i], numBuckets);
-            callback(i, stats);
+        case 1:
+            kernels::selected = kernels::makeKernelTable<1>();
+            break;
+        case 2:
+            kernels::selected = kernels::makeKernelTable<2>();
+            break;
+        case 3:
+            kernels::selected = kernels::makeKernelTable<3>();
+            break;
+        case 4:
+            kernels::selected = kernels::makeKernelTable<4>();
+            break;
+        default:
+            kernels::selected = kernels::makeKernelTable<0>();
         }
+    }
 
-        // Process precomputed
-        auto numPrecomputed = sequenceData.precomputedStats.size();
-        for (size_t i = 0; i < numPrecomputed; ++i)
-        {
-            callback(numSequences + i, sequenceData.precomputedStats[i]);
-        }
+    // Calculate sequence statistics for a single polymer sequence, divided into buckets
+    PositionalStats calculatePositionalSequenceStats(const std::vector<SpeciesID> &sequence, const size_t &numBuckets)
+    {
+        PositionalStats stats(numBuckets);
+        kernels::selected.sequenceStats(sequence, stats);
+        return stats;
     }
 
-    /*
+    /**
+     * @brief Same statistics as above, computed directly on a bit-packed sequence.
+     * Words holding only monomers are processed whole: monomer counts are popcounts of the
+     * fields matching each monomer code within a bucket, and run boundaries are the non-zero
+     * fields of the word XORed with itself shifted by one field. Words containing other units
+     * (e.g. initiator fragments) fall back to the per-unit loop.
      */
-    SequenceSummary calculateSequenceSummary(const analysis::RawSequenceData &sequenceData)
+    PositionalStats calculatePositionalSequenceStats(const SequenceBuffer &sequence, const size_t &numBuckets)
     {
-        // Calculate sequence stats matrix (polymers x (monomers*fields)) -> Summed across all buckets
-        // Calculate positional average stats (buckets x (monomers*fields)) -> Summed across all polymers
-        Eigen::MatrixXd sequenceStatsMatrix = Eigen::MatrixXd::Zero(sequenceData.length, SequenceStats::SIZE());
-        std::vector<SequenceStats> positionalStats(NUM_BUCKETS);
-
-        forEachStats(
-            sequenceData,
-            NUM_BUCKETS,
-            [&](size_t index, const std::vector<SequenceStats> &allStats)
-            {
-                for (size_t bucket = 0; bucket < NUM_BUCKETS; ++bucket)
-                {
-                    const auto &stats = allStats[bucket];
-                    sequenceStatsMatrix.row(index) += stats.toEigen();
-                    positionalStats[bucket] += stats;
-                }
-            });
+        PositionalStats stats(numBuckets);
+        kernels::selected.packedSequenceStats(sequence.getWords(), sequence.size(), nullptr, 0, stats);
+        return stats;
+    }
+
+    /**
+     * @brief Statistics of the chain formed by head followed by tail in reverse order (the two
+     * halves of a chain terminated by combination), without joining the sequences.
+     */
+    PositionalStats calculatePositionalSequenceStats(const SequenceBuffer &head, const SequenceBuffer &tail, const size_t &numBuckets)
+    {
+        PositionalStats stats(numBuckets);
+        kernels::selected.packedSequenceStats(head.getWords(), head.size(), tail.getWords(), tail.size(), stats);
+        return stats;
+    }
+
+    /**
+     * @brief Adds the statistics of head (followed by tail in reverse order, if given) to stats,
+     * e.g. to sum many chains without a temporary per chain.
+     */
+    void addPositionalSequenceStats(const SequenceBuffer &head, const SequenceBuffer *tail, PositionalStats &stats)
+    {
+        if (tail)
+            kernels::selected.packedSequenceStats(head.getWords(), head.size(), tail->getWords(), tail->size(), stats);
+        else
+            kernels::selected.packedSequenceStats(head.getWords(), head.size(), nullptr, 0, stats);
+    }
+
+    // Same as above on packed words copied out of the SequenceBuffers
+    void addPositionalSequenceStats(const SequenceWord *head, size_t headSize, const SequenceWord *tail, size_t tailSize, PositionalStats &stats)
+    {
+        kernels::selected.packedSequenceStats(head, headSize, tail, tailSize, stats);
+    }
+
+    inline void ChainAggregate::addChain(const PositionalStats &chainStats)
+    {
+        positionalStats += chainStats;
 
-        return SequenceSummary{sequenceStatsMatrix, positionalStats};
+        // Monomer counts of the chain are the first NUM_MONOMERS values of its summed row
+        kernels::selected.sumBuckets(chainStats, row.data());
+        moments.add(row.data());
     }
 }
@@ -0,0 +1,140 @@
+#pragma once
+#include "common.h"
+#include "kmc/builder.h"
+#include "outputs/metadata.h"
+#include "reactions/compiled_kernel.h"
+#include "reactions/reaction_table.h"
+
+namespace compiled
+{
+    struct ReactionInfo
+    {
+        size_t variantIndex;      // Alternative of the reaction class in ReactionVariant
+        size_t rateConstantIndex; // Index into the rateconstants section
+    };
+
+    struct EndGroupInfo
+    {
+        SpeciesID polymerTypeID;
+        size_t length;
+        uint64_t key; // EndGroupTable::pack of the end group (0 if longer than MAX_LENGTH)
+    };
+
+    /**
+     * @brief Compile-time description of a model, emitted by runkmc-compile next to its kernel.
+     * It is only used to check the model parsed at startup (see verifyModel), as the kernel's
+     * casts are only valid for the exact model it was generated from. The kernel does not read it.
+     */
+    struct ModelTables
+    {
+        const ReactionInfo *reactions;
+        size_t numReactions;
+        const int8_t *unitStoichiometry; // numReactions x numSpeciesIDs, row-major
+        size_t numSpeciesIDs;
+        const EndGroupInfo *endGroups;
+        size_t numPolymerTypes;
+    };
+
+    /**
+     * @brief Net change of every unit count (indexed by SpeciesID) per reaction event.
+     */
+    inline std::vector<int> calculateUnitStoichiometry(const Reaction *reaction, size_t numSpeciesIDs)
+    {
+        std::vector<int> stoichiometry(numSpeciesIDs, 0);
+        for (const auto &unit : reaction->getUnitReactants())
+            --stoichiometry[unit->ID];
+        for (const auto &unit : reaction->getUnitProducts())
+            ++stoichiometry[unit->ID];
+        return stoichiometry;
+    }
+
+    inline EndGroupInfo calculateEndGroupInfo(const PolymerType &polymerType)
+    {
+        const auto &endGroup = polymerType.getEndGroup();
+        uint64_t key = 0;
+        if (endGroup.size() <= EndGroupTable::MAX_LENGTH)
+            key = EndGroupTable::pack(endGroup.begin(), endGroup.end());
+        return EndGroupInfo{polymerType.ID, endGroup.size(), key};
+    }
+
+    inline size_t getRateConstantIndex(const Reaction *reaction, const std::vector<RateConstant> &rateConstants)
+    {
+        for (size_t i = 0; i < rateConstants.size(); ++i)
+            if (rateConstants[i].name == reaction->rateConstant.name)
+                return i;
+        return rateConstants.size();
+    }
+
+    inline void verifyModel(const KMC &model, const ModelTables &tables)
+    {
+        const auto &reactionSet = model.getReactionSet();
+        const auto &polymerTypes = model.getSpeciesSet().getPolymerTypes();
+
+        if (reactionSet.getNumReactions() != tables.numReactions || polymerTypes.size() != tables.numPolymerTypes ||
+            registry::REGISTERED_SPECIES.size() + 1 != tables.numSpeciesIDs)
+            console::error("Compiled model does not match the embedded model file. Recompile it with runkmc-compile.");
+
+        for (size_t i = 0; i < tables.numReactions; ++i)
+        {
+            Reaction *reaction = reactionSet.getReaction(i);
+            bool matches = ReactionTable::toVariant(reaction).index() == tables.reactions[i].variantIndex &&
+                           getRateConstantIndex(reaction, reactionSet.getRateConstants()) == tables.reactions[i].rateConstantIndex;
+
+            auto stoichiometry = calculateUnitStoichiometry(reaction, tables.numSpeciesIDs);
+            for (size_t id = 0; id < tables.numSpeciesIDs; ++id)
+                matches = matches && stoichiometry[id] == tables.unitStoichiometry[i * tables.numSpeciesIDs + id];
+
+            if (!matches)
+                console::error("Compiled reaction " + std::to_string(i) + " (" + reaction->toString() + ") does not match the model. Recompile it with runkmc-compile.");
+        }
+
+        for (size_t i = 0; i < tables.numPolymerTypes; ++i)
+        {
+            auto info = calculateEndGroupInfo(polymerTypes[i]);
+            const auto &expected = tables.endGroups[i];
+            if (info.polymerTypeID != expected.polymerTypeID || info.length != expected.length || info.key != expected.key)
+                console::error("Compiled end group of " + polymerTypes[i].name + " does not match the model. Recompile it with runkmc-compile.");
+        }
+    }
+
+    /**
+     * @brief Main function of a compiled model: <outputDirectory> [flags].
+     * The embedded model file is written to the output directory and parsed from there, so the
+     * simulation is set up exactly as RunKMC would set it up from the original file.
+     */
+    inline int runCompiledModel(int argc, char **argv, const char *modelSource, const Kernel &kernel, const ModelTables &tables)
+    {
+        if (argc < 2)
+        {
+            std::cerr
+                << "Usage: " << argv[0]
+                << " <outputDirectory>"
+                << " [--report-polymers] [--report-sequences] [--seed <integer>] [--replica <integer>] [--threads <integer>]\n";
+            exit(EXIT_FAILURE);
+        }
+
+        config::CommandLineConfig config;
+        config.outputDir = argv[1];
+        KMCBuilder::parseOptionalArguments(config, argc, argv, 2);
+
+        if (!KMCBuilder::prepareOutputDir(config.outputDir))
+            exit(EXIT_FAILURE);
+
+        config.inputFilepath = (std::filesystem::path(config.outputDir) / "input.txt").string();
+        std::ofstream inputFile(config.inputFilepath);
+        inputFile << modelSource;
+        inputFile.close();
+
+        registerKernel(&kernel);
+
+        auto model = KMCBuilder::fromFile(config);
+
+        verifyModel(model, tables);
+
+        output::writeMetadata(model);
+
+        model.run();
+
+        return EXIT_SUCCESS;
+    }
+}
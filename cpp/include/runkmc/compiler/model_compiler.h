@@ -0,0 +1,140 @@
+#pragma once
+#include <array>
+#include <sstream>
+
+#include "common.h"
+#include "compiler/compiled_model.h"
+
+/**
+ * @brief Ahead-of-time model compiler. Emits a C++ translation unit with the model file embedded,
+ * constexpr tables describing it (see compiled::ModelTables) and a reaction kernel in which every
+ * reaction is a case of a switch statement calling its final class directly. The tables only
+ * verify the model at startup; rates and events are computed by the reaction classes themselves.
+ */
+namespace model_compiler
+{
+    // Class names of the ReactionVariant alternatives, in order
+    static const std::array<const char *, std::variant_size_v<ReactionVariant>> REACTION_CLASS_NAMES = {
+        "Elementary",
+        "InitiatorDecomposition",
+        "Initiation",
+        "Propagation",
+        "Depropagation",
+        "TerminationDisproportionation",
+        "TerminationCombination",
+        "ChainTransferToMonomer",
+        "ThermalInitiationMonomer",
+    };
+
+    static const std::string RAW_STRING_DELIMITER = "RUNKMC_MODEL";
+
+    static std::string readFile(const std::string &filepath)
+    {
+        std::ifstream file(filepath);
+        if (!file.is_open())
+            console::input_error("Cannot open model file: " + filepath);
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        return buffer.str();
+    }
+
+    static std::string generateSource(const std::string &modelFilepath, const KMCBuilder::ModelComponents &model)
+    {
+        std::string modelSource = readFile(modelFilepath);
+        if (modelSource.find(")" + RAW_STRING_DELIMITER + "\"") != std::string::npos)
+            console::input_error("Model file contains the reserved sequence )" + RAW_STRING_DELIMITER + "\".");
+
+        const ReactionSet &reactionSet = model.reactionSet;
+        const auto &polymerTypes = model.speciesSet.getPolymerTypes();
+        size_t numReactions = reactionSet.getNumReactions();
+        size_t numSpeciesIDs = registry::REGISTERED_SPECIES.size() + 1;
+
+        std::vector<std::string> classNames(numReactions);
+        for (size_t i = 0; i < numReactions; ++i)
+            classNames[i] = REACTION_CLASS_NAMES[ReactionTable::toVariant(reactionSet.getReaction(i)).index()];
+
+        std::ostringstream out;
+        out << "// Generated by runkmc-compile from " << modelFilepath << ". Do not edit.\n"
+            << "#include \"common.h\"\n"
+            << "#include \"compiler/compiled_model.h\"\n\n";
+
+        // ---------- Model tables ----------
+        out << "namespace model\n{\n";
+        out << "    constexpr const char *SOURCE = R\"" << RAW_STRING_DELIMITER << "(" << modelSource << ")" << RAW_STRING_DELIMITER << "\";\n\n";
+        out << "    constexpr size_t NUM_REACTIONS = " << numReactions << ";\n";
+        out << "    constexpr size_t NUM_SPECIES_IDS = " << numSpeciesIDs << ";\n";
+        out << "    constexpr size_t NUM_POLYMER_TYPES = " << polymerTypes.size() << ";\n\n";
+
+        out << "    constexpr compiled::ReactionInfo REACTIONS[NUM_REACTIONS] = {\n";
+        for (size_t i = 0; i < numReactions; ++i)
+        {
+            Reaction *reaction = reactionSet.getReaction(i);
+            out << "        {" << ReactionTable::toVariant(reaction).index() << ", "
+                << compiled::getRateConstantIndex(reaction, model.rateConstants) << "}, // "
+                << reaction->getType() << ": " << reaction->toString() << "\n";
+        }
+        out << "    };\n\n";
+
+        out << "    constexpr int8_t UNIT_STOICHIOMETRY[NUM_REACTIONS * NUM_SPECIES_IDS] = {\n";
+        for (size_t i = 0; i < numReactions; ++i)
+        {
+            auto stoichiometry = compiled::calculateUnitStoichiometry(reactionSet.getReaction(i), numSpeciesIDs);
+            out << "       ";
+            for (const auto &change : stoichiometry)
+                out << " " << change << ",";
+            out << "\n";
+        }
+        out << "    };\n\n";
+
+        out << "    constexpr compiled::EndGroupInfo END_GROUPS[NUM_POLYMER_TYPES] = {\n";
+        for (const auto &polymerType : polymerTypes)
+        {
+            auto info = compiled::calculateEndGroupInfo(polymerType);
+            out << "        {" << int(info.polymerTypeID) << ", " << info.length << ", " << info.key << "ULL}, // " << polymerType.name << "\n";
+        }
+        out << "    };\n\n";
+
+        out << "    constexpr compiled::ModelTables TABLES = {REACTIONS, NUM_REACTIONS, UNIT_STOICHIOMETRY, NUM_SPECIES_IDS, END_GROUPS, NUM_POLYMER_TYPES};\n";
+        out << "}\n\n";
+
+        // ---------- Kernel ----------
+        out << "namespace kernel\n{\n";
+        out << "    double calculateRate(Reaction *const *reactions, size_t reactionIndex, double NAV)\n"
+            << "    {\n"
+            << "        switch (reactionIndex)\n"
+            << "        {\n";
+        for (size_t i = 0; i < numReactions; ++i)
+            out << "        case " << i << ":\n"
+                << "            return compiled::rate<" << classNames[i] << ">(reactions[" << i << "], NAV);\n";
+        out << "        }\n"
+            << "        return 0;\n"
+            << "    }\n\n";
+
+        out << "    void calculateRates(Reaction *const *reactions, double NAV, double *rates)\n"
+            << "    {\n";
+        for (size_t i = 0; i < numReactions; ++i)
+            out << "        rates[" << i << "] = compiled::rate<" << classNames[i] << ">(reactions[" << i << "], NAV);\n";
+        out << "    }\n\n";
+
+        out << "    void react(Reaction *const *reactions, size_t reactionIndex, TouchedSpecies &touched)\n"
+            << "    {\n"
+            << "        switch (reactionIndex)\n"
+            << "        {\n";
+        for (size_t i = 0; i < numReactions; ++i)
+            out << "        case " << i << ":\n"
+                << "            compiled::react<" << classNames[i] << ">(reactions[" << i << "], touched);\n"
+                << "            return;\n";
+        out << "        }\n"
+            << "    }\n\n";
+
+        out << "    constexpr compiled::Kernel KERNEL = {calculateRate, calculateRates, react};\n";
+        out << "}\n\n";
+
+        out << "int main(int argc, char **argv)\n"
+            << "{\n"
+            << "    return compiled::runCompiledModel(argc, argv, model::SOURCE, kernel::KERNEL, model::TABLES);\n"
+            << "}\n";
+
+        return out.str();
+    }
+}
@@ -5,6 +5,7 @@
 #include <algorithm>
 
 #include "core/types.h"
+#include "species/sequence_codec.h"
 
 #define AVOGADROS 6.022149e+23;
 
@@ -26,9 +27,15 @@ namespace registry
 
     static size_t NUM_MONOMERS;
     static std::vector<SpeciesID> MONOMER_IDS;
+    static std::vector<SpeciesID> UNIT_IDS; // getAllUnitIDs(), cached by finalizeRegistry
+    static SequenceCodec SEQUENCE_CODEC;    // Bit-packed encoding of polymer sequences
 
     RegisteredSpecies getByID(SpeciesID id)
     {
+        // IDs are handed out in registration order, starting at 1
+        if (id >= 1 && id <= REGISTERED_SPECIES.size() && REGISTERED_SPECIES[id - 1].ID == id)
+            return REGISTERED_SPECIES[id - 1];
+
         auto it = std::find_if(REGISTERED_SPECIES.begin(), REGISTERED_SPECIES.end(),
                                [id](const RegisteredSpecies &species)
                                { return species.ID == id; });
@@ -142,6 +149,8 @@ namespace registry
 
         NUM_MONOMERS = getNumOf(SpeciesType::MONOMER);
         MONOMER_IDS = getIDsOf(SpeciesType::MONOMER);
+        UNIT_IDS = getAllUnitIDs();
+        SEQUENCE_CODEC = SequenceCodec(MONOMER_IDS, UNIT_IDS);
     }
 
     static void printRegisteredSpecies()
@@ -5,6 +5,12 @@
 static const size_t NUM_BUCKETS = 30;
 typedef uint8_t SpeciesID;
 
+// IDs of the units and polymer types whose counts were changed by a reaction event.
+typedef std::vector<SpeciesID> TouchedSpecies;
+
+// Index of a Polymer slot in the PolymerPool. PolymerTypes store these instead of pointers.
+typedef uint32_t PolymerHandle;
+
 class ReactionType
 {
 public:
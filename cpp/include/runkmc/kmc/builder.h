@@ -10,12 +10,38 @@ class KMCBuilder
 {
 
 public:
+    /**
+     * @brief Simulation inputs built from a model file, before they are handed to a KMC object.
+     */
+    struct ModelComponents
+    {
+        config::SimulationConfig options;
+        SpeciesSet speciesSet;
+        std::vector<RateConstant> rateConstants;
+        ReactionSet reactionSet;
+    };
+
     static KMC fromFile(config::CommandLineConfig config)
+    {
+        rng_utils::seed(config.seed, config.replica);
+
+        auto components = buildModelComponents(config.inputFilepath);
+
+        KMC model(components.speciesSet, components.reactionSet, config, components.options);
+
+        return model;
+    }
+
+    /**
+     * @brief Parses and builds all species, rate constants and reactions of a model file
+     * and finalizes the species registry.
+     */
+    static ModelComponents buildModelComponents(const std::string &inputFilepath)
     {
         std::string line;
-        std::ifstream modelFile(config.inputFilepath);
+        std::ifstream modelFile(inputFilepath);
         if (!modelFile.is_open())
-            console::input_error("Cannot open model file: " + config.inputFilepath);
+            console::input_error("Cannot open model file: " + inputFilepath);
 
         std::vector<std::string> parameterLines, speciesLines, rateConstantLines, reactionLines;
 
@@ -56,13 +82,12 @@ public:
         auto simConfig = buildSimulationConfig(parameterLines);
         auto speciesSet = buildSpeciesSet(speciesLines, simConfig);
         auto rateConstants = buildRateConstants(rateConstantLines);
-        auto reactionSet = buildReactionSet(reactionLines, speciesSet, rateConstants);
+        auto reactionSet = buildReactionSet(reactionLines, speciesSet, rateConstants, simConfig);
 
         registry::finalizeRegistry();
+        analysis::selectKernels(registry::NUM_MONOMERS);
 
-        KMC model(speciesSet, reactionSet, config, simConfig);
-
-        return model;
+        return ModelComponents{simConfig, std::move(speciesSet), std::move(rateConstants), std::move(reactionSet)};
     }
 
     static config::CommandLineConfig parseArguments(int argc, char **argv)
@@ -72,7 +97,7 @@ public:
             std::cerr
                 << "Usage: " << argv[0]
                 << " <inputFilePath> <outputDirectory>"
-                << " [--report-polymers] [--report-sequences]\n";
+                << " [--report-polymers] [--report-sequences] [--seed <integer>] [--replica <integer>] [--threads <integer>]\n";
             exit(EXIT_FAILURE);
         }
 
@@ -80,8 +105,23 @@ public:
         config.inputFilepath = argv[1];
         config.outputDir = argv[2];
 
-        // Parse optional flags
-        for (int i = 3; i < argc; ++i)
+        parseOptionalArguments(config, argc, argv, 3);
+
+        if (!validateInputFile(config.inputFilepath))
+            exit(EXIT_FAILURE);
+
+        if (!prepareOutputDir(config.outputDir))
+            exit(EXIT_FAILURE);
+
+        return config;
+    }
+
+    /**
+     * @brief Parses the optional flags (--report-polymers, --seed, ...) in argv[first:].
+     */
+    static void parseOptionalArguments(config::CommandLineConfig &config, int argc, char **argv, int first)
+    {
+        for (int i = first; i < argc; ++i)
         {
             std::string arg = argv[i];
 
@@ -89,20 +129,69 @@ public:
                 config.reportPolymers = true;
             else if (arg == "--report-sequences")
                 config.reportSequences = true;
+            else if (arg == "--seed" && i + 1 < argc)
+            {
+                try
+                {
+                    config.seed = std::stoull(argv[++i]);
+                }
+                catch (const std::exception &e)
+                {
+                    std::cerr << "Invalid seed: " << argv[i] << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+            }
+            else if (arg == "--replica" && i + 1 < argc)
+            {
+                try
+                {
+                    unsigned long replica = std::stoul(argv[++i]);
+                    if (replica > std::numeric_limits<uint32_t>::max())
+                        throw std::out_of_range("replica");
+                    config.replica = uint32_t(replica);
+                }
+                catch (const std::exception &e)
+                {
+                    std::cerr << "Invalid replica: " << argv[i] << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+            }
+            else if (arg == "--threads" && i + 1 < argc)
+            {
+                try
+                {
+                    unsigned long threads = std::stoul(argv[++i]);
+                    if (threads == 0 || threads > 1024)
+                        throw std::out_of_range("threads");
+                    config.threads = size_t(threads);
+                }
+                catch (const std::exception &e)
+                {
+                    std::cerr << "Invalid thread count: " << argv[i] << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+            }
             else
             {
                 std::cerr << "Unknown argument: " << arg << std::endl;
                 exit(EXIT_FAILURE);
             }
         }
+    }
 
-        if (!validateInputFile(config.inputFilepath))
-            exit(EXIT_FAILURE);
-
-        if (!prepareOutputDir(config.outputDir))
-            exit(EXIT_FAILURE);
-
-        return config;
+    static bool prepareOutputDir(const std::string &dirPath)
+    {
+        try
+        {
+            std::filesystem::create_directories(dirPath);
+            return true;
+        }
+        catch (const std::filesystem::filesystem_error &e)
+        {
+            std::cerr << "Failed to create output directory: " << dirPath << "\n"
+                      << e.what() << std::endl;
+            return false;
+        }
     }
 
 private:
@@ -112,6 +201,41 @@ private:
         input::readVariableRequired(parameterLines, "num_units", config.numParticles);
         input::readVariableRequired(parameterLines, "termination_time", config.terminationTime);
         input::readVariableRequired(parameterLines, "analysis_time", config.analysisTime);
+
+        std::string solverName = "linear";
+        input::readVariable(parameterLines, "solver", solverName);
+        config.solver = config::parseSolverType(solverName);
+        input::readVariable(parameterLines, "resync_interval", config.rateResyncInterval);
+        if (config.rateResyncInterval == 0)
+            console::input_error("resync_interval must be at least 1.");
+
+        std::string dispatchName = "virtual";
+        input::readVariable(parameterLines, "dispatch", dispatchName);
+        config.dispatch = config::parseDispatchType(dispatchName);
+        if (compiled::registeredKernel != nullptr)
+            config.dispatch = config::DispatchType::COMPILED;
+
+        std::string deadChainMode = "retain";
+        input::readVariable(parameterLines, "dead_chains", deadChainMode);
+        config.deadChains = config::parseDeadChainMode(deadChainMode);
+
+        std::string momentMode = "live";
+        input::readVariable(parameterLines, "moments", momentMode);
+        config.moments = config::parseMomentMode(momentMode);
+
+        std::string analysisMode = "sync";
+        input::readVariable(parameterLines, "analysis_mode", analysisMode);
+        config.analysisMode = config::parseAnalysisMode(analysisMode);
+        if (config.analysisMode == config::AnalysisMode::ASYNC && config.moments != config::MomentMode::LIVE)
+            console::input_error("analysis_mode = async requires moments = live.");
+
+        input::readVariable(parameterLines, "leap_threshold", config.leapThreshold);
+        input::readVariable(parameterLines, "leap_epsilon", config.leapEpsilon);
+        if (config.leapThreshold > 0 && config.solver == config::SolverType::NEXT_REACTION)
+            console::input_error("leap_threshold cannot be used with the next_reaction solver.");
+        if (config.leapEpsilon <= 0 || config.leapEpsilon >= 1)
+            console::input_error("leap_epsilon must be between 0 and 1.");
+
         return config;
         // + more when I think of them
     }
@@ -224,7 +348,7 @@ private:
                         }
                     }
                 }
-                polymerTypes.push_back(PolymerType(speciesName, endSequence));
+                polymerTypes.push_back(PolymerType(speciesName, id, endSequence));
                 polymerGroupStructs.push_back(PolymerGroupStruct(speciesName, {polymerTypes.size() - 1}));
             }
             else
@@ -250,15 +374,20 @@ private:
         return rateConstants;
     }
 
-    static ReactionSet buildReactionSet(const std::vector<std::string> &reactionLines, SpeciesSet &speciesSet, const std::vector<RateConstant> &rateConstants)
+    static ReactionSet buildReactionSet(const std::vector<std::string> &reactionLines, SpeciesSet &speciesSet, const std::vector<RateConstant> &rateConstants,
+                                        const config::SimulationConfig &config)
     {
         std::vector<PolymerTypeGroup> polyTypeGroups = speciesSet.getPolyTypeGroups();
         std::vector<PolymerTypeGroupPtr> polyGroupPtrs = speciesSet.getPolymerGroupPtrs();
 
         std::vector<Unit> &units = speciesSet.getUnits();
+        PolymerPool *polymerPool = speciesSet.getPolymerPool();
         std::vector<Reaction *> reactions;
         reactions.reserve(reactionLines.size());
 
+        std::vector<PolymerTypeGroupPtr> deadProducts;                              // Groups receiving terminated chains
+        std::vector<std::pair<PolymerTypeGroupPtr, std::string>> polyReactantLines; // Polymer reactant group -> reaction line
+
         for (const auto &line : reactionLines)
         {
             std::vector<Unit *> unitReactants;
@@ -335,12 +464,19 @@ private:
             }
             uint8_t sameReactant = 0;
 
+            for (const auto &polyReactant : polyReactants)
+                polyReactantLines.emplace_back(polyReactant, line);
+            if (reactionType == TerminationCombination::TYPE || reactionType == ChainTransferToMonomer::TYPE)
+                deadProducts.push_back(polyProducts[0]);
+            else if (reactionType == TerminationDisproportionation::TYPE)
+                deadProducts.insert(deadProducts.end(), polyProducts.begin(), polyProducts.begin() + 2);
+
             if (reactionType == Elementary::TYPE)
                 reactions.push_back(new Elementary(rateConstant, unitReactants, unitProducts));
             else if (reactionType == InitiatorDecomposition::TYPE)
                 reactions.push_back(new InitiatorDecomposition(rateConstant, unitReactants[0], unitProducts[0], unitProducts[1], unitReactants[0]->efficiency));
             else if (reactionType == Initiation::TYPE)
-                reactions.push_back(new Initiation(rateConstant, unitReactants[0], unitReactants[1], polyProducts[0]));
+                reactions.push_back(new Initiation(rateConstant, unitReactants[0], unitReactants[1], polyProducts[0], polymerPool));
             else if (reactionType == Propagation::TYPE)
                 reactions.push_back(new Propagation(rateConstant, polyReactants[0], unitReactants[0], polyProducts[0]));
             else if (reactionType == Depropagation::TYPE)
@@ -358,13 +494,29 @@ private:
                 reactions.push_back(new TerminationDisproportionation(rateConstant, polyReactants[0], polyReactants[1], polyProducts[0], polyProducts[1], sameReactant));
             }
             else if (reactionType == ChainTransferToMonomer::TYPE)
-                reactions.push_back(new ChainTransferToMonomer(rateConstant, polyReactants[0], unitReactants[0], polyProducts[0], polyProducts[1]));
+                reactions.push_back(new ChainTransferToMonomer(rateConstant, polyReactants[0], unitReactants[0], polyProducts[0], polyProducts[1], polymerPool));
             else if (reactionType == ThermalInitiationMonomer::TYPE)
-                reactions.push_back(new ThermalInitiationMonomer(rateConstant, unitReactants[0], unitReactants[1], unitReactants[2], polyProducts[0], polyProducts[1]));
+                reactions.push_back(new ThermalInitiationMonomer(rateConstant, unitReactants[0], unitReactants[1], unitReactants[2], polyProducts[0], polyProducts[1], polymerPool));
             else
                 console::input_error(reactionType + " is not a valid reaction type.");
         }
+
+        // Streamed dead chains are released once folded, so dead types cannot be drawn from
+        if (config.deadChains != config::DeadChainMode::RETAIN)
+        {
+            for (const auto &[polyReactant, reactionLine] : polyReactantLines)
+                for (const auto &deadProduct : deadProducts)
+                    for (const auto &deadType : deadProduct->getPolymerTypes())
+                    {
+                        const auto &reactantTypes = polyReactant->getPolymerTypes();
+                        if (std::find(reactantTypes.begin(), reactantTypes.end(), deadType) != reactantTypes.end())
+                            console::input_error("dead_chains = " + config::toString(config.deadChains) + " cannot be used when terminated chains of " +
+                                                 deadType->name + " react (" + reactionLine + "). Use dead_chains = retain.");
+                    }
+        }
+
         ReactionSet reactionSet(reactions, rateConstants);
+        reactionSet.buildDependencyGraph();
 
         return reactionSet;
     }
@@ -399,19 +551,4 @@ private:
         file.close();
         return true;
     }
-
-    static bool prepareOutputDir(const std::string &dirPath)
-    {
-        try
-        {
-            std::filesystem::create_directories(dirPath);
-            return true;
-        }
-        catch (const std::filesystem::filesystem_error &e)
-        {
-            std::cerr << "Failed to create output directory: " << dirPath << "\n"
-                      << e.what() << std::endl;
-            return false;
-        }
-    }
 };
\ No newline at end of file
@@ -4,6 +4,209 @@
 
 namespace config
 {
+    /**
+     * @brief Algorithm used to select the next reaction in each KMC step.
+     * LINEAR is the reference implementation (cumulative probability scan).
+     */
+    enum class SolverType
+    {
+        LINEAR,
+        TREE,
+        COMPOSITION_REJECTION,
+        NEXT_REACTION,
+    };
+
+    static SolverType parseSolverType(std::string name)
+    {
+        str::trim(name);
+        if (!name.empty() && name.back() == ';')
+            name.pop_back();
+
+        if (name == "linear")
+            return SolverType::LINEAR;
+        if (name == "tree")
+            return SolverType::TREE;
+        if (name == "composition_rejection")
+            return SolverType::COMPOSITION_REJECTION;
+        if (name == "next_reaction")
+            return SolverType::NEXT_REACTION;
+
+        console::input_error("Unknown solver " + name + " (expected linear, tree, composition_rejection or next_reaction).");
+        return SolverType::LINEAR; // Not reached as console::input_error will exit
+    }
+
+    static std::string toString(SolverType solver)
+    {
+        switch (solver)
+        {
+        case SolverType::TREE:
+            return "tree";
+        case SolverType::COMPOSITION_REJECTION:
+            return "composition_rejection";
+        case SolverType::NEXT_REACTION:
+            return "next_reaction";
+        default:
+            return "linear";
+        }
+    }
+
+    /**
+     * @brief How reactions are called in the simulation loop. VIRTUAL calls through Reaction*,
+     * VARIANT through a contiguous std::variant table with static dispatch and COMPILED through
+     * the kernel of a model compiled by runkmc-compile (never set from the model file). COMPILED
+     * is a static-dispatch variant of VARIANT: the reaction classes are resolved per reaction
+     * index by a generated switch instead of by std::visit.
+     */
+    enum class DispatchType
+    {
+        VIRTUAL,
+        VARIANT,
+        COMPILED,
+    };
+
+    static DispatchType parseDispatchType(std::string name)
+    {
+        str::trim(name);
+        if (!name.empty() && name.back() == ';')
+            name.pop_back();
+
+        if (name == "virtual")
+            return DispatchType::VIRTUAL;
+        if (name == "variant")
+            return DispatchType::VARIANT;
+
+        console::input_error("Unknown dispatch " + name + " (expected virtual or variant).");
+        return DispatchType::VIRTUAL; // Not reached as console::input_error will exit
+    }
+
+    static std::string toString(DispatchType dispatch)
+    {
+        switch (dispatch)
+        {
+        case DispatchType::VARIANT:
+            return "variant";
+        case DispatchType::COMPILED:
+            return "compiled";
+        default:
+            return "virtual";
+        }
+    }
+
+    /**
+     * @brief What happens to terminated chains. RETAIN keeps every dead chain (with its positional
+     * stats) so it is re-summed at each analysis. STREAM folds each dead chain once into running
+     * aggregates of its PolymerType and releases the chain. SPILL folds like STREAM and also
+     * appends the sequence to a memory-mapped store in the output directory.
+     */
+    enum class DeadChainMode
+    {
+        RETAIN,
+        STREAM,
+        SPILL,
+    };
+
+    static DeadChainMode parseDeadChainMode(std::string name)
+    {
+        str::trim(name);
+        if (!name.empty() && name.back() == ';')
+            name.pop_back();
+
+        if (name == "retain")
+            return DeadChainMode::RETAIN;
+        if (name == "stream")
+            return DeadChainMode::STREAM;
+        if (name == "spill")
+            return DeadChainMode::SPILL;
+
+        console::input_error("Unknown dead_chains mode " + name + " (expected retain, stream or spill).");
+        return DeadChainMode::RETAIN; // Not reached as console::input_error will exit
+    }
+
+    static std::string toString(DeadChainMode mode)
+    {
+        switch (mode)
+        {
+        case DeadChainMode::STREAM:
+            return "stream";
+        case DeadChainMode::SPILL:
+            return "spill";
+        default:
+            return "retain";
+        }
+    }
+
+    /**
+     * @brief How chain length and molecular weight averages are computed at each analysis.
+     * LIVE uses the moments kept up to date by every PolymerType, FULL recomputes them from every
+     * chain, VALIDATE does both, warns if they disagree and reports the full pass.
+     */
+    enum class MomentMode
+    {
+        LIVE,
+        FULL,
+        VALIDATE,
+    };
+
+    static MomentMode parseMomentMode(std::string name)
+    {
+        str::trim(name);
+        if (!name.empty() && name.back() == ';')
+            name.pop_back();
+
+        if (name == "live")
+            return MomentMode::LIVE;
+        if (name == "full")
+            return MomentMode::FULL;
+        if (name == "validate")
+            return MomentMode::VALIDATE;
+
+        console::input_error("Unknown moments mode " + name + " (expected live, full or validate).");
+        return MomentMode::LIVE; // Not reached as console::input_error will exit
+    }
+
+    static std::string toString(MomentMode mode)
+    {
+        switch (mode)
+        {
+        case MomentMode::FULL:
+            return "full";
+        case MomentMode::VALIDATE:
+            return "validate";
+        default:
+            return "live";
+        }
+    }
+
+    /**
+     * @brief When the analysis at each analysis_time runs. SYNC pauses the simulation for it. ASYNC
+     * copies what the analysis needs into a snapshot and analyzes it (and writes the outputs) on
+     * a background thread while the simulation continues.
+     */
+    enum class AnalysisMode
+    {
+        SYNC,
+        ASYNC,
+    };
+
+    static AnalysisMode parseAnalysisMode(std::string name)
+    {
+        str::trim(name);
+        if (!name.empty() && name.back() == ';')
+            name.pop_back();
+
+        if (name == "sync")
+            return AnalysisMode::SYNC;
+        if (name == "async")
+            return AnalysisMode::ASYNC;
+
+        console::input_error("Unknown analysis_mode " + name + " (expected sync or async).");
+        return AnalysisMode::SYNC; // Not reached as console::input_error will exit
+    }
+
+    static std::string toString(AnalysisMode mode)
+    {
+        return mode == AnalysisMode::ASYNC ? "async" : "sync";
+    }
 
     struct CommandLineConfig
     {
@@ -11,6 +214,9 @@ namespace config
         std::string outputDir;
         bool reportPolymers = false;
         bool reportSequences = false;
+        uint64_t seed = rng_utils::DEFAULT_SEED;
+        uint32_t replica = 0; // Selects an independent random stream for the same seed
+        size_t threads = 1;   // Threads for the analysis pass (results do not depend on it)
     };
 
     struct SimulationConfig
@@ -18,5 +224,13 @@ namespace config
         uint64_t numParticles;
         double terminationTime;
         double analysisTime;
+        SolverType solver = SolverType::LINEAR;
+        uint64_t rateResyncInterval = 100000; // Steps between full reaction rate recalculations
+        uint64_t leapThreshold = 0;           // Minimum reactant count for tau-leaping (0 = disabled)
+        double leapEpsilon = 0.03;            // Tau-leaping error control parameter
+        DispatchType dispatch = DispatchType::VIRTUAL;
+        DeadChainMode deadChains = DeadChainMode::RETAIN;
+        MomentMode moments = MomentMode::LIVE;
+        AnalysisMode analysisMode = AnalysisMode::SYNC;
     };
-}
\ No newline at end of file
+}
@@ -1,4 +1,6 @@
 #pragma once
+#include <future>
+
 #include "common.h"
 #include "reactions/reaction_set.h"
 #include "species/species_set.h"
@@ -24,7 +26,12 @@ public:
         state.kmc.NAV = speciesSet.getNAV();
 
         speciesSet.updatePolyTypeGroups();
+        speciesSet.setDeadChainMode(options.deadChains, paths.deadChainFile().string());
 
+        reactionSet.setSolver(options.solver);
+        reactionSet.setResyncInterval(options.rateResyncInterval);
+        reactionSet.setDispatch(options.dispatch);
+        reactionSet.setLeapParameters(options.leapThreshold, options.leapEpsilon);
         reactionSet.updateReactionProbabilities(state.kmc.NAV);
 
         output::writeStateHeaders(paths, config);
@@ -61,10 +68,15 @@ public:
             }
 
             // Analyze current state
-            updateSystemState();
-
-            output::writeState(state, paths, config);
+            if (options.analysisMode == config::AnalysisMode::ASYNC)
+                submitAnalysis();
+            else
+            {
+                updateSystemState();
+                output::writeState(state, paths, config);
+            }
         }
+        waitForAnalysis();
 
         if (config.reportPolymers)
             output::writePolymers(paths, speciesSet);
@@ -95,28 +107,90 @@ private:
     // Core Kinetic Monte Carlo Simulation Step
     void step()
     {
-        size_t reactionIndex = reactionSet.chooseRandomReactionIndex();
-
-        Reaction *reaction = reactionSet.getReaction(reactionIndex);
+        if (options.solver == config::SolverType::NEXT_REACTION)
+        {
+            stepNextReaction();
+            return;
+        }
+        if (options.leapThreshold > 0)
+        {
+            stepHybrid();
+            return;
+        }
 
-        reaction->react();
+        size_t reactionIndex = reactionSet.chooseRandomReactionIndex();
 
-        speciesSet.updatePolyTypeGroups();
+        touchedSpecies.clear();
+        reactionSet.fireReaction(reactionIndex, touchedSpecies);
 
-        reactionSet.updateReactionProbabilities(state.kmc.NAV);
+        reactionSet.updateReactionProbabilities(state.kmc.NAV, touchedSpecies);
 
         if (reactionSet.cantProceed())
             return;
 
         // Update time
-        double rn = rng_utils::dis(rng_utils::rng) + 1e-40;
+        double rn = rng_utils::uniform() + 1e-40;
         state.kmc.kmcTime -= log(rn) / reactionSet.getTotalReactionRate();
         state.kmc.kmcStep += 1;
     }
 
+    // Next Reaction Method step: the reaction with the earliest putative time fires,
+    // then the clock moves to the putative time of the following event.
+    void stepNextReaction()
+    {
+        size_t reactionIndex = reactionSet.getNextReactionIndex();
+        double reactionTime = reactionSet.getNextReactionTime();
+
+        touchedSpecies.clear();
+        reactionSet.fireReaction(reactionIndex, touchedSpecies);
+
+        reactionSet.updateNextReactionTimes(reactionIndex, reactionTime, touchedSpecies);
+
+        if (reactionSet.cantProceed())
+            return;
+
+        state.kmc.kmcTime = reactionSet.getNextReactionTime();
+        state.kmc.kmcStep += 1;
+    }
+
+    // Hybrid step: leaped reactions advance by tau, which is cut short by the next exact
+    // event if that event happens first. The exact event then fires at the end of the leap.
+    void stepHybrid()
+    {
+        double exactRate = reactionSet.getTotalReactionRate();
+        double exactTime = INFINITY;
+        if (exactRate > 0)
+        {
+            double rn = rng_utils::uniform() + 1e-40;
+            exactTime = -log(rn) / exactRate;
+        }
+        double leapTime = reactionSet.selectLeapTime();
+        double tau = std::min(exactTime, leapTime);
+
+        bool fireExact = exactTime <= leapTime;
+        size_t reactionIndex = fireExact ? reactionSet.chooseRandomReactionIndex() : 0;
+
+        touchedSpecies.clear();
+        reactionSet.leap(tau, touchedSpecies);
+        // The leap may have consumed the reactants of the chosen reaction
+        if (fireExact && reactionSet.calculateRate(reactionIndex) > 0)
+            reactionSet.fireReaction(reactionIndex, touchedSpecies);
+
+        reactionSet.updateReactionProbabilities(state.kmc.NAV, touchedSpecies);
+
+        state.kmc.kmcTime += tau;
+        state.kmc.kmcStep += 1;
+    }
+
     // ********** State functions **********
 
     void updateSystemState()
+    {
+        updateKMCState();
+        analysis::analyze(speciesSet, state, options.moments, config.threads);
+    }
+
+    void updateKMCState()
     {
         auto currentTime = std::chrono::steady_clock::now();
         state.kmc.simulationTime = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - startTime).count() / 1000.;
@@ -124,8 +198,36 @@ private:
             state.kmc.simulationTimePer1e6Steps = state.kmc.simulationTime / (state.kmc.kmcStep / 1e6);
 
         state.species = speciesSet.getStateData();
+    }
 
-        analysis::analyze(speciesSet, state);
+    /**
+     * @brief Snapshots the current state and analyzes it (and writes the outputs) on a background
+     * thread (analysis_mode = async). Only one analysis runs at a time, so outputs stay in order.
+     */
+    void submitAnalysis()
+    {
+        updateKMCState();
+        auto snapshot = std::make_shared<analysis::AnalysisSnapshot>(analysis::takeSnapshot(speciesSet, state));
+
+        waitForAnalysis();
+        pendingAnalysis = std::async(
+            std::launch::async,
+            [this, snapshot]()
+            {
+                SystemState result = analysis::analyzeSnapshot(*snapshot, config.threads);
+                output::writeState(result, paths, config);
+                return result;
+            });
+    }
+
+    // Waits for the background analysis, if any, and keeps its results
+    void waitForAnalysis()
+    {
+        if (!pendingAnalysis.valid())
+            return;
+        SystemState result = pendingAnalysis.get();
+        state.analysis = result.analysis;
+        state.sequence = result.sequence;
     }
 
     // Simulation inputs
@@ -135,11 +237,15 @@ private:
     // Managing outputs
     SimulationPaths paths;
     SystemState state;
+    std::future<SystemState> pendingAnalysis; // Background analysis (analysis_mode = async)
 
     // Core simulation objects
     ReactionSet reactionSet;
     SpeciesSet speciesSet;
 
+    // Species changed by the last reaction event
+    TouchedSpecies touchedSpecies;
+
     // Simulation start time
     std::chrono::steady_clock::time_point startTime;
 };
\ No newline at end of file
@@ -168,7 +168,7 @@ struct AnalysisState
 struct SequenceState
 {
     KMCState kmcState;
-    std::vector<analysis::SequenceStats> stats;
+    analysis::PositionalStats stats;
 
     static std::vector<std::string> getTitles()
     {
@@ -196,11 +196,11 @@ struct SequenceState
         output.push_back(std::to_string(bucket));
 
         for (size_t i = 0; i < registry::NUM_MONOMERS; ++i)
-            output.push_back(std::to_string(stats[bucket].monCounts[i]));
+            output.push_back(std::to_string(stats.get(bucket, analysis::PositionalStats::MON_COUNTS, i)));
         for (size_t i = 0; i < registry::NUM_MONOMERS; ++i)
-            output.push_back(std::to_string(stats[bucket].seqCounts[i]));
+            output.push_back(std::to_string(stats.get(bucket, analysis::PositionalStats::SEQ_COUNTS, i)));
         for (size_t i = 0; i < registry::NUM_MONOMERS; ++i)
-            output.push_back(std::to_string(stats[bucket].seqLengths2[i]));
+            output.push_back(std::to_string(stats.get(bucket, analysis::PositionalStats::SEQ_LENGTHS2, i)));
 
         return output;
     }
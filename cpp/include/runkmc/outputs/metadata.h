@@ -57,6 +57,14 @@ namespace output
             node["timestamp"] = std::chrono::system_clock::to_time_t(now);
             node["unix_timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
 
+            YAML::Node rng;
+            rng["generator"] = rng_utils::GENERATOR_NAME;
+            rng["seed"] = model.getConfig().seed;
+            rng["replica"] = model.getConfig().replica;
+            rng["uniform_stream"] = rng_utils::UNIFORM_STREAM;
+            rng["distribution_stream"] = rng_utils::DISTRIBUTION_STREAM;
+            node["rng"] = rng;
+
             return node;
         }
 
@@ -68,8 +76,17 @@ namespace output
             node["num_particles"] = model.getOptions().numParticles;
             node["termination_time"] = model.getOptions().terminationTime;
             node["analysis_time"] = model.getOptions().analysisTime;
+            node["solver"] = config::toString(model.getOptions().solver);
+            node["resync_interval"] = model.getOptions().rateResyncInterval;
+            node["dispatch"] = config::toString(model.getOptions().dispatch);
+            node["leap_threshold"] = model.getOptions().leapThreshold;
+            node["leap_epsilon"] = model.getOptions().leapEpsilon;
+            node["dead_chains"] = config::toString(model.getOptions().deadChains);
+            node["moments"] = config::toString(model.getOptions().moments);
+            node["analysis_mode"] = config::toString(model.getOptions().analysisMode);
             node["report_sequences"] = model.getConfig().reportSequences;
             node["report_polymers"] = model.getConfig().reportPolymers;
+            node["threads"] = model.getConfig().threads;
             return node;
         }
 
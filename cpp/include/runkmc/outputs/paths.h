@@ -33,4 +33,5 @@ public:
     std::filesystem::path sequencesFile() const { return baseDir / "sequences.csv"; }
     std::filesystem::path metadataFile() const { return baseDir / "metadata.yaml"; }
     std::filesystem::path inputFile() const { return baseDir / "input.txt"; }
+    std::filesystem::path deadChainFile() const { return baseDir / "dead_chains.bin"; }
 };
\ No newline at end of file
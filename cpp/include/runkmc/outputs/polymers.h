@@ -13,12 +13,35 @@ namespace output
         std::ofstream output;
         output.open(filepath.c_str(), std::ios::out);
 
-        const auto polymers = speciesSet.getPolymers();
-        for (const auto &polymer : polymers)
+        speciesSet.forEachPolymer(
+            [&](const Polymer &polymer)
+            {
+                if (!polymer.isCompressed())
+                    output << polymer.getSequenceString() << std::endl;
+            });
+
+        // Dead chains spilled to disk (dead_chains = spill)
+        if (const ChainStore *chainStore = speciesSet.getChainStore())
         {
-            if (polymer->isCompressed())
-                continue;
-            output << polymer->getSequenceString() << std::endl;
+            const auto &codec = registry::SEQUENCE_CODEC;
+            chainStore->forEachChain(
+                [&](const ChainStore::ChainRecord &record, const SequenceWord *words)
+                {
+                    auto unitString = [&](const SequenceWord *sequenceWords, size_t i)
+                    {
+                        uint64_t code = (sequenceWords[i / codec.unitsPerWord] >> ((i % codec.unitsPerWord) * codec.bits)) & codec.fieldMask;
+                        return std::to_string(codec.decode(code)) + " ";
+                    };
+
+                    // Coupled chains: the head, then the second half in reverse
+                    std::string sequenceString;
+                    for (size_t i = 0; i < record.length; ++i)
+                        sequenceString += unitString(words, i);
+                    const SequenceWord *coupledWords = words + ChainStore::getNumWords(record.length);
+                    for (size_t i = record.coupledLength; i-- > 0;)
+                        sequenceString += unitString(coupledWords, i);
+                    output << sequenceString << std::endl;
+                });
         }
 
         output.close();
@@ -61,7 +61,7 @@ namespace output
 
         void writeState(std::ostream &out) const
         {
-            for (size_t bucket = 0; bucket < sequenceState.stats.size(); ++bucket)
+            for (size_t bucket = 0; bucket < sequenceState.stats.getNumBuckets(); ++bucket)
             {
                 auto data = sequenceState.getDataAsVector(bucket);
 
@@ -0,0 +1,36 @@
+#pragma once
+#include "common.h"
+#include "reactions/reactions.h"
+
+namespace compiled
+{
+    /**
+     * @brief Model-specialized reaction kernel emitted by runkmc-compile.
+     * Every case of the generated switch statements casts the reaction to its final class,
+     * so rate evaluations and reaction events are direct (inlinable) calls. The rate and react
+     * code itself is that of the reaction classes; only the dispatch is specialized.
+     */
+    struct Kernel
+    {
+        double (*calculateRate)(Reaction *const *reactions, size_t reactionIndex, double NAV);
+        void (*calculateRates)(Reaction *const *reactions, double NAV, double *rates);
+        void (*react)(Reaction *const *reactions, size_t reactionIndex, TouchedSpecies &touched);
+    };
+
+    // Set by the main function of a compiled model before the model is built
+    inline const Kernel *registeredKernel = nullptr;
+
+    inline void registerKernel(const Kernel *kernel) { registeredKernel = kernel; }
+
+    template <typename T>
+    inline double rate(const Reaction *reaction, double NAV)
+    {
+        return static_cast<const T *>(reaction)->calculateRate(NAV);
+    }
+
+    template <typename T>
+    inline void react(Reaction *reaction, TouchedSpecies &touched)
+    {
+        static_cast<T *>(reaction)->react(touched);
+    }
+}
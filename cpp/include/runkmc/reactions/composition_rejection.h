@@ -0,0 +1,165 @@
+#pragma once
+#include <cmath>
+#include <vector>
+
+#include "common.h"
+
+/**
+ * @brief Composition-rejection selection over a set of reaction rates.
+ * Reactions are grouped into bins by the power of two bounding their rate, so every rate
+ * in a bin lies in [2^(e-1), 2^e). A bin is first chosen proportionally to its total
+ * (composition), then a member is drawn uniformly and accepted with probability rate / 2^e
+ * (rejection, accepted at least half of the time). Both the expected selection cost and the
+ * cost of updating a single rate are independent of the number of reactions.
+ */
+class CompositionRejection
+{
+public:
+    CompositionRejection() {};
+
+    void resize(size_t numReactions)
+    {
+        rates.assign(numReactions, 0);
+        binOf.assign(numReactions, NO_BIN);
+        positionInBin.assign(numReactions, 0);
+        bins.assign(NUM_EXPONENTS, Bin());
+        activeBins.clear();
+    }
+
+    /**
+     * @brief Rebuilds all bins from scratch. Also clears any floating-point drift
+     * accumulated in the bin totals by incremental updates.
+     */
+    void build(const std::vector<double> &rates_)
+    {
+        resize(rates_.size());
+        for (size_t i = 0; i < rates_.size(); ++i)
+            update(i, rates_[i]);
+    }
+
+    void update(size_t index, double rate)
+    {
+        size_t newBin = (rate > 0) ? getBinIndex(rate) : NO_BIN;
+        size_t oldBin = binOf[index];
+
+        if (newBin == oldBin)
+        {
+            if (newBin != NO_BIN)
+                bins[newBin].total += rate - rates[index];
+            rates[index] = rate;
+            return;
+        }
+
+        if (oldBin != NO_BIN)
+            removeFromBin(index, oldBin);
+        rates[index] = rate;
+        if (newBin != NO_BIN)
+            insertIntoBin(index, newBin);
+    }
+
+    size_t choose() const
+    {
+        // Composition: choose a bin proportionally to its total rate
+        double target = rng_utils::uniform() * total();
+        size_t binIndex = activeBins.back();
+        for (const auto &activeBin : activeBins)
+        {
+            if (target < bins[activeBin].total)
+            {
+                binIndex = activeBin;
+                break;
+            }
+            target -= bins[activeBin].total;
+        }
+
+        // Rejection: draw members uniformly until one is accepted
+        const Bin &bin = bins[binIndex];
+        double upperBound = std::ldexp(1.0, int(binIndex) - EXPONENT_OFFSET);
+        while (true)
+        {
+            double r = rng_utils::uniform() * bin.members.size();
+            size_t member = static_cast<size_t>(r);
+            if (member >= bin.members.size())
+                member = bin.members.size() - 1;
+
+            size_t reactionIndex = bin.members[member];
+            if ((r - member) * upperBound < rates[reactionIndex])
+                return reactionIndex;
+        }
+    }
+
+    double total() const
+    {
+        double totalRate = 0;
+        for (const auto &activeBin : activeBins)
+            totalRate += bins[activeBin].total;
+        return totalRate;
+    }
+
+    size_t getNumActiveBins() const { return activeBins.size(); }
+
+private:
+    struct Bin
+    {
+        double total = 0;
+        std::vector<size_t> members;
+        size_t activePosition = 0;
+    };
+
+    // std::frexp exponents of positive doubles (including subnormals) lie in [-1073, 1024]
+    static inline const int EXPONENT_OFFSET = 1080;
+    static inline const size_t NUM_EXPONENTS = 2110;
+    static inline const size_t NO_BIN = SIZE_MAX;
+
+    std::vector<double> rates;
+    std::vector<size_t> binOf;
+    std::vector<size_t> positionInBin;
+    std::vector<Bin> bins;
+    std::vector<size_t> activeBins; // Bins with at least one member
+
+    static size_t getBinIndex(double rate)
+    {
+        int exponent;
+        std::frexp(rate, &exponent); // rate = m * 2^exponent, m in [0.5, 1)
+        return size_t(exponent + EXPONENT_OFFSET);
+    }
+
+    void insertIntoBin(size_t index, size_t binIndex)
+    {
+        Bin &bin = bins[binIndex];
+        if (bin.members.empty())
+        {
+            bin.total = 0;
+            bin.activePosition = activeBins.size();
+            activeBins.push_back(binIndex);
+        }
+        binOf[index] = binIndex;
+        positionInBin[index] = bin.members.size();
+        bin.members.push_back(index);
+        bin.total += rates[index];
+    }
+
+    void removeFromBin(size_t index, size_t binIndex)
+    {
+        Bin &bin = bins[binIndex];
+
+        // Swap and pop!
+        size_t position = positionInBin[index];
+        size_t last = bin.members.back();
+        bin.members[position] = last;
+        positionInBin[last] = position;
+        bin.members.pop_back();
+        binOf[index] = NO_BIN;
+
+        if (bin.members.empty())
+        {
+            bin.total = 0; // Reset exactly so that drift cannot leave an empty bin selectable
+            size_t lastActive = activeBins.back();
+            activeBins[bin.activePosition] = lastActive;
+            bins[lastActive].activePosition = bin.activePosition;
+            activeBins.pop_back();
+        }
+        else
+            bin.total -= rates[index];
+    }
+};
@@ -2,6 +2,13 @@
 #include "common.h"
 #include "reactions/reactions.h"
 #include "reactions/utils.h"
+#include "reactions/composition_rejection.h"
+#include "reactions/tau_leaping.h"
+#include "reactions/reaction_table.h"
+#include "reactions/compiled_kernel.h"
+#include "utils/sum_tree.h"
+#include "utils/indexed_heap.h"
+#include "kmc/config.h"
 
 /**
  * @brief Stores set of all reactions and can calculate cumulative properties such as
@@ -17,6 +24,10 @@ public:
         reactionRates.resize(numReactions);
         reactionProbabilities.resize(numReactions);
         reactionCumulativeProbabilities.resize(numReactions);
+        rateTree.resize(numReactions);
+        rejectionTable.resize(numReactions);
+        lastUpdated.assign(numReactions, 0);
+        tauLeaping = TauLeaping(reactions, 0, 0);
     };
 
     ReactionSet() {};
@@ -24,11 +35,20 @@ public:
 
     /**
      * @brief Calculate and update reaction probabilities. First updates the reaction rates,
-     * then calculates the probability and cumulative probability vectors.
+     * then calculates the probability and cumulative probability vectors. Solvers other than
+     * linear instead rebuild their selection structure from the recalculated rates.
      */
     void updateReactionProbabilities(double NAV_)
     {
         NAV = NAV_;
+        std::vector<size_t> reclassified;
+        tauLeaping.classify(reclassified);
+        if (solver != config::SolverType::LINEAR)
+        {
+            resyncReactionRates();
+            return;
+        }
+
         updateReactionRates();
         reactionProbabilities[0] = reactionRates[0] / totalReactionRate;
         reactionCumulativeProbabilities[0] = reactionProbabilities[0];
@@ -39,9 +59,101 @@ public:
         }
     }
 
+    /**
+     * @brief Recalculate only the rates of reactions that depend on a species touched by the
+     * last reaction event. Falls back to a full update for the linear (reference) solver, when
+     * no dependency graph was built, and every resyncInterval steps to bound floating-point drift.
+     */
+    void updateReactionProbabilities(double NAV_, const TouchedSpecies &touched)
+    {
+        if (solver == config::SolverType::LINEAR || speciesDependents.empty() || ++stepsSinceResync >= resyncInterval)
+        {
+            stepsSinceResync = 0;
+            updateReactionProbabilities(NAV_);
+            return;
+        }
+
+        ++updateStamp;
+        std::vector<size_t> reclassified;
+        tauLeaping.classify(reclassified);
+        for (const auto &reactionIndex : reclassified)
+        {
+            lastUpdated[reactionIndex] = updateStamp;
+            reactionRates[reactionIndex] = -1; // Force the selection structure to be updated
+            updateReactionRate(reactionIndex);
+        }
+        updateDependentRates(touched);
+        totalReactionRate = getSelectionTotal();
+    }
+
+    /**
+     * @brief Leap size for the reactions currently simulated by tau-leaping (INFINITY if none).
+     */
+    double selectLeapTime()
+    {
+        if (!tauLeaping.isEnabled() || tauLeaping.getTotalRate() == 0)
+            return INFINITY;
+        return tauLeaping.selectTimeStep();
+    }
+
+    void leap(double tau, TouchedSpecies &touched) { tauLeaping.leap(tau, touched); }
+
+    /**
+     * @brief Next Reaction Method update after the reaction firedIndex fired at time.
+     * The fired reaction draws a new putative time; every other dependent reaction has its
+     * putative time rescaled by (old rate / new rate) so no new random numbers are needed.
+     */
+    void updateNextReactionTimes(size_t firedIndex, double time, const TouchedSpecies &touched)
+    {
+        currentTime = time;
+        bool resync = speciesDependents.empty() || ++stepsSinceResync >= resyncInterval;
+
+        ++updateStamp;
+        lastUpdated[firedIndex] = updateStamp;
+        reactionRates[firedIndex] = calculateRate(firedIndex);
+        nextReactionTimes.update(firedIndex, sampleNextReactionTime(reactionRates[firedIndex]));
+
+        if (resync)
+        {
+            stepsSinceResync = 0;
+            resyncReactionRates();
+        }
+        else
+            updateDependentRates(touched);
+    }
+
+    size_t getNextReactionIndex() const { return nextReactionTimes.top(); }
+    double getNextReactionTime() const { return nextReactionTimes.topKey(); }
+
+    /**
+     * @brief Build the species -> reaction dependency graph from the rate dependencies
+     * (unit reactants and polymer reactant groups) of every reaction.
+     */
+    void buildDependencyGraph()
+    {
+        speciesDependents.clear();
+        for (size_t i = 0; i < numReactions; ++i)
+        {
+            for (const auto &id : reactions[i]->getRateDependencies())
+            {
+                if (id >= speciesDependents.size())
+                    speciesDependents.resize(id + 1);
+                auto &dependents = speciesDependents[id];
+                if (dependents.empty() || dependents.back() != i)
+                    dependents.push_back(i);
+            }
+        }
+        lastUpdated.assign(numReactions, 0);
+    }
+
     size_t chooseRandomReactionIndex() const
     {
-        double randomNumber = rng_utils::dis(rng_utils::rng);
+        if (solver == config::SolverType::TREE)
+            return rateTree.find(rng_utils::uniform() * totalReactionRate);
+        if (solver == config::SolverType::COMPOSITION_REJECTION)
+            return rejectionTable.choose();
+
+        double randomNumber = rng_utils::uniform();
         for (size_t reactionIndex = 0; reactionIndex < numReactions; ++reactionIndex)
         {
             if (randomNumber <= reactionCumulativeProbabilities[reactionIndex])
@@ -62,12 +174,55 @@ public:
         }
     }
 
+    /**
+     * @brief Rate of a reaction, dispatched through the variant table or the virtual call.
+     */
+    double calculateRate(size_t reactionIndex) const
+    {
+        if (dispatch == config::DispatchType::VARIANT)
+            return reactionTable.calculateRate(reactionIndex, NAV);
+        if (dispatch == config::DispatchType::COMPILED)
+            return compiledKernel->calculateRate(reactions.data(), reactionIndex, NAV);
+        return reactions[reactionIndex]->calculateRate(NAV);
+    }
+
+    void fireReaction(size_t reactionIndex, TouchedSpecies &touched)
+    {
+        if (dispatch == config::DispatchType::VARIANT)
+            reactionTable.react(reactionIndex, touched);
+        else if (dispatch == config::DispatchType::COMPILED)
+            compiledKernel->react(reactions.data(), reactionIndex, touched);
+        else
+            reactions[reactionIndex]->react(touched);
+    }
+
     Reaction *getReaction(size_t reactionIndex) const { return reactions[reactionIndex]; }
     size_t getNumReactions() const { return numReactions; }
     const std::vector<RateConstant> &getRateConstants() const { return rateConstants; }
     double getTotalReactionRate() const { return totalReactionRate; }
-    bool cantProceed() const { return totalReactionRate == 0; }
+    bool cantProceed() const
+    {
+        if (solver == config::SolverType::NEXT_REACTION)
+            return nextReactionTimes.empty() || nextReactionTimes.topKey() == INFINITY;
+        return totalReactionRate == 0 && (!tauLeaping.isEnabled() || tauLeaping.getTotalRate() == 0);
+    }
     void setNAV(double NAV) { this->NAV = NAV; }
+    void setSolver(config::SolverType solver_) { solver = solver_; }
+    void setResyncInterval(uint64_t interval) { resyncInterval = interval; }
+    void setDispatch(config::DispatchType dispatch_)
+    {
+        dispatch = dispatch_;
+        if (dispatch == config::DispatchType::VARIANT)
+            reactionTable = ReactionTable(reactions);
+        if (dispatch == config::DispatchType::COMPILED)
+        {
+            compiledKernel = compiled::registeredKernel;
+            if (compiledKernel == nullptr)
+                console::error("Compiled dispatch requested but no compiled kernel is registered.");
+        }
+    }
+    void setLeapParameters(uint64_t threshold, double epsilon) { tauLeaping = TauLeaping(reactions, threshold, epsilon); }
+    config::SolverType getSolver() const { return solver; }
     double getNAV() const { return NAV; }
 
 private:
@@ -82,17 +237,155 @@ private:
 
     double NAV;
 
+    config::SolverType solver = config::SolverType::LINEAR;
+    SumTree<double> rateTree;                 // Unnormalized reaction rates for O(log R) selection
+    CompositionRejection rejectionTable;      // Reaction rates binned by powers of two for O(1) selection
+    IndexedMinHeap<double> nextReactionTimes; // Putative (absolute) firing time of every reaction
+    double currentTime = 0;
+
+    std::vector<std::vector<size_t>> speciesDependents; // Species ID -> reactions whose rate depends on it
+    std::vector<uint64_t> lastUpdated;                  // Deduplicates reactions within one incremental update
+    uint64_t updateStamp = 0;
+    uint64_t stepsSinceResync = 0;
+    uint64_t resyncInterval = 100000;
+
+    config::DispatchType dispatch = config::DispatchType::VIRTUAL;
+    ReactionTable reactionTable; // Statically dispatched copy of the reactions (variant dispatch)
+    const compiled::Kernel *compiledKernel = nullptr;
+
+    TauLeaping tauLeaping; // Unit-only reactions simulated by leaping rather than selected exactly
+
     /**
      * @brief Calculate and update reaction rates for all reactions.
      * Also updates total reaction rate.
      */
     void updateReactionRates()
     {
+        calculateSelectionRates();
         totalReactionRate = 0;
         for (size_t i = 0; i < numReactions; ++i)
-        {
-            reactionRates[i] = reactions[i]->calculateRate(NAV);
             totalReactionRate += reactionRates[i];
+    }
+
+    /**
+     * @brief Recalculate all reaction rates and rebuild the selection structure of the
+     * active solver from them. The total reaction rate is read from that structure.
+     */
+    void resyncReactionRates()
+    {
+        if (solver == config::SolverType::NEXT_REACTION)
+        {
+            if (nextReactionTimes.size() != numReactions)
+                initializeNextReactionTimes();
+            for (size_t i = 0; i < numReactions; ++i)
+                updateReactionRate(i);
+            return;
         }
+
+        calculateSelectionRates();
+
+        if (solver == config::SolverType::TREE)
+            rateTree.build(reactionRates);
+        else if (solver == config::SolverType::COMPOSITION_REJECTION)
+            rejectionTable.build(reactionRates);
+
+        totalReactionRate = getSelectionTotal();
+    }
+
+    void updateReactionRate(size_t reactionIndex)
+    {
+        double rate = calculateSelectionRate(reactionIndex);
+        if (rate == reactionRates[reactionIndex])
+            return;
+        double oldRate = reactionRates[reactionIndex];
+        reactionRates[reactionIndex] = rate;
+
+        if (solver == config::SolverType::TREE)
+            rateTree.update(reactionIndex, rate);
+        else if (solver == config::SolverType::COMPOSITION_REJECTION)
+            rejectionTable.update(reactionIndex, rate);
+        else if (solver == config::SolverType::NEXT_REACTION)
+            nextReactionTimes.update(reactionIndex, rescaleNextReactionTime(reactionIndex, oldRate, rate));
+    }
+
+    /**
+     * @brief Rate of a reaction as seen by exact selection. Leaped reactions are hidden from
+     * selection (rate of 0) and their true rate is handed to the tau-leaping scheme instead.
+     */
+    double calculateSelectionRate(size_t reactionIndex)
+    {
+        double rate = calculateRate(reactionIndex);
+        if (!tauLeaping.isLeaping(reactionIndex))
+            return rate;
+        tauLeaping.setRate(reactionIndex, rate);
+        return 0;
+    }
+
+    void calculateSelectionRates()
+    {
+        // The compiled kernel evaluates all rates in one unrolled, statically dispatched pass
+        if (dispatch == config::DispatchType::COMPILED && !tauLeaping.isEnabled())
+        {
+            compiledKernel->calculateRates(reactions.data(), NAV, reactionRates.data());
+            return;
+        }
+        for (size_t i = 0; i < numReactions; ++i)
+            reactionRates[i] = calculateSelectionRate(i);
+    }
+
+    void updateDependentRates(const TouchedSpecies &touched)
+    {
+        for (const auto &id : touched)
+        {
+            if (id >= speciesDependents.size())
+                continue;
+            for (const auto &reactionIndex : speciesDependents[id])
+            {
+                if (lastUpdated[reactionIndex] == updateStamp)
+                    continue;
+                lastUpdated[reactionIndex] = updateStamp;
+                updateReactionRate(reactionIndex);
+            }
+        }
+    }
+
+    void initializeNextReactionTimes()
+    {
+        std::vector<double> times(numReactions);
+        for (size_t i = 0; i < numReactions; ++i)
+        {
+            reactionRates[i] = calculateRate(i);
+            times[i] = sampleNextReactionTime(reactionRates[i]);
+        }
+        nextReactionTimes.build(times);
+    }
+
+    double sampleNextReactionTime(double rate) const
+    {
+        if (rate == 0)
+            return INFINITY;
+        double rn = rng_utils::uniform() + 1e-40;
+        return currentTime - log(rn) / rate;
+    }
+
+    /**
+     * @brief Gibson-Bruck time rescaling: the remaining waiting time of a reaction that did not
+     * fire shrinks or grows with the ratio of its old and new rates. A reaction becoming
+     * possible again (old rate of zero) draws a fresh putative time.
+     */
+    double rescaleNextReactionTime(size_t reactionIndex, double oldRate, double newRate) const
+    {
+        if (newRate == 0)
+            return INFINITY;
+        if (oldRate == 0)
+            return sampleNextReactionTime(newRate);
+        return currentTime + (oldRate / newRate) * (nextReactionTimes.get(reactionIndex) - currentTime);
+    }
+
+    double getSelectionTotal() const
+    {
+        if (solver == config::SolverType::COMPOSITION_REJECTION)
+            return rejectionTable.total();
+        return rateTree.total();
     }
 };
\ No newline at end of file
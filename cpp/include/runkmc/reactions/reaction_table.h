@@ -0,0 +1,84 @@
+#pragma once
+#include <optional>
+#include <variant>
+
+#include "common.h"
+#include "reactions/reactions.h"
+
+typedef std::variant<
+    Elementary,
+    InitiatorDecomposition,
+    Initiation,
+    Propagation,
+    Depropagation,
+    TerminationDisproportionation,
+    TerminationCombination,
+    ChainTransferToMonomer,
+    ThermalInitiationMonomer>
+    ReactionVariant;
+
+/**
+ * @brief Contiguous copy of the reaction set stored as a closed std::variant.
+ * All reaction classes are final, so std::visit resolves react() and calculateRate()
+ * statically and they can be inlined. The copies share the unit and polymer group
+ * pointers of the original reactions.
+ */
+class ReactionTable
+{
+public:
+    ReactionTable() {};
+
+    ReactionTable(const std::vector<Reaction *> &reactions)
+    {
+        table.reserve(reactions.size());
+        for (const auto &reaction : reactions)
+            table.push_back(toVariant(reaction));
+    }
+
+    double calculateRate(size_t reactionIndex, double NAV) const
+    {
+        return std::visit([NAV](const auto &reaction)
+                          { return reaction.calculateRate(NAV); },
+                          table[reactionIndex]);
+    }
+
+    void react(size_t reactionIndex, TouchedSpecies &touched)
+    {
+        std::visit([&touched](auto &reaction)
+                   { reaction.react(touched); },
+                   table[reactionIndex]);
+    }
+
+    size_t size() const { return table.size(); }
+
+    /**
+     * @brief Copies a reaction into the variant alternative of its concrete class.
+     */
+    static ReactionVariant toVariant(Reaction *reaction)
+    {
+        std::optional<ReactionVariant> result;
+        tryConvert<Elementary>(reaction, result) ||
+            tryConvert<InitiatorDecomposition>(reaction, result) ||
+            tryConvert<Initiation>(reaction, result) ||
+            tryConvert<Propagation>(reaction, result) ||
+            tryConvert<Depropagation>(reaction, result) ||
+            tryConvert<TerminationDisproportionation>(reaction, result) ||
+            tryConvert<TerminationCombination>(reaction, result) ||
+            tryConvert<ChainTransferToMonomer>(reaction, result) ||
+            tryConvert<ThermalInitiationMonomer>(reaction, result);
+        if (!result)
+            console::error("Reaction " + reaction->toString() + " (" + reaction->getType() + ") has no variant dispatch.");
+        return std::move(*result);
+    }
+
+private:
+    std::vector<ReactionVariant> table;
+
+    template <typename T>
+    static bool tryConvert(Reaction *reaction, std::optional<ReactionVariant> &result)
+    {
+        if (auto *derived = dynamic_cast<T *>(reaction))
+            result.emplace(std::in_place_type<T>, *derived);
+        return result.has_value();
+    }
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include "common.h"
 #include "species/polymer_type.h"
+#include "species/polymer_pool.h"
 #include "reactions/utils.h"
 
 struct RateConstant
@@ -32,8 +33,10 @@ public:
     /**
      * @brief Undergoes reaction. Automatically updates unit counts and moves pointers to Polymer objects
      * into containers based on type.
+     *
+     * @param touched receives the IDs of every unit and polymer type whose count changed
      */
-    virtual void react() = 0;
+    virtual void react(TouchedSpecies &touched) = 0;
 
     /**
      * @brief Calculates rate of reaction for a given NAV.
@@ -44,6 +47,28 @@ public:
 
     virtual const std::string &getType() const = 0;
 
+    /**
+     * @brief Whether the reaction only changes unit counts and can therefore be fired many times
+     * at once by tau-leaping.
+     */
+    virtual bool canLeap() const { return false; }
+
+    /**
+     * @brief Fires the reaction numEvents times at once. Only valid when canLeap() is true.
+     */
+    virtual void leap(uint64_t, TouchedSpecies &)
+    {
+        console::error("Reaction " + toString() + " cannot be leaped.");
+    }
+
+    /**
+     * @brief Expected number of each unit product formed per reaction event.
+     */
+    virtual double getProductYield() const { return 1.0; }
+
+    const std::vector<Unit *> &getUnitReactants() const { return unitReactants; }
+    const std::vector<Unit *> &getUnitProducts() const { return unitProducts; }
+
     std::string toString() const
     {
         return rxn_print::reactionToString(unitReactants, polyReactants, unitProducts, polyProducts, false);
@@ -54,6 +79,21 @@ public:
         return rxn_print::reactionToString(unitReactants, polyReactants, unitProducts, polyProducts, true);
     }
 
+    /**
+     * @brief IDs of the species that calculateRate depends on: every unit reactant and every
+     * polymer type belonging to a polymer reactant group.
+     */
+    std::vector<SpeciesID> getRateDependencies() const
+    {
+        std::vector<SpeciesID> ids;
+        for (const auto &unit : unitReactants)
+            ids.push_back(unit->ID);
+        for (const auto &poly : polyReactants)
+            for (const auto &polyType : poly->getPolymerTypes())
+                ids.push_back(polyType->ID);
+        return ids;
+    }
+
     std::vector<std::string> getReactantNames() const
     {
         std::vector<std::string> reactantNames;
@@ -85,7 +125,7 @@ protected:
  * @brief Elementary reaction (e.g., A + B ––> C)
  * Arbitrary number of unit reactants forming arbitrary number of unit products.
  */
-class Elementary : public Reaction
+class Elementary final : public Reaction
 {
 public:
     static inline const std::string &TYPE = ReactionType::ELEMENTARY;
@@ -96,12 +136,34 @@ public:
         unitProducts = std::move(unitProducts_);
     };
 
-    void react()
+    void react(TouchedSpecies &touched)
     {
         for (size_t i = 0; i < unitReactants.size(); ++i)
+        {
             --unitReactants[i]->count;
+            touched.push_back(unitReactants[i]->ID);
+        }
         for (size_t i = 0; i < unitProducts.size(); ++i)
+        {
             ++unitProducts[i]->count;
+            touched.push_back(unitProducts[i]->ID);
+        }
+    }
+
+    bool canLeap() const { return true; }
+
+    void leap(uint64_t numEvents, TouchedSpecies &touched)
+    {
+        for (size_t i = 0; i < unitReactants.size(); ++i)
+        {
+            unitReactants[i]->count -= numEvents;
+            touched.push_back(unitReactants[i]->ID);
+        }
+        for (size_t i = 0; i < unitProducts.size(); ++i)
+        {
+            unitProducts[i]->count += numEvents;
+            touched.push_back(unitProducts[i]->ID);
+        }
     }
 
     double calculateRate(double NAV) const
@@ -119,7 +181,7 @@ public:
  * @brief Initiator decomposition reaction (e.g., AIBN ––> I + I)
  * Decomoposition of initiator molecule to form two active primary radicals.
  */
-class InitiatorDecomposition : public Reaction
+class InitiatorDecomposition final : public Reaction
 {
 public:
     static inline const std::string &TYPE = ReactionType::INITIATOR_DECOMPOSITION;
@@ -131,15 +193,34 @@ public:
         unitProducts[1] = unitProduct2;
     }
 
-    void react()
+    void react(TouchedSpecies &touched)
     {
         --unitReactants[0]->count;
-        if (rng_utils::dis(rng_utils::rng) <= efficiency)
+        if (rng_utils::uniform() <= efficiency)
             ++unitProducts[0]->count;
-        if (rng_utils::dis(rng_utils::rng) <= efficiency)
+        if (rng_utils::uniform() <= efficiency)
             ++unitProducts[1]->count;
+        touched.push_back(unitReactants[0]->ID);
+        touched.push_back(unitProducts[0]->ID);
+        touched.push_back(unitProducts[1]->ID);
     }
 
+    bool canLeap() const { return true; }
+
+    // Each of the numEvents decompositions forms every product with probability efficiency.
+    void leap(uint64_t numEvents, TouchedSpecies &touched)
+    {
+        std::binomial_distribution<uint64_t> binomial(numEvents, efficiency);
+        unitReactants[0]->count -= numEvents;
+        unitProducts[0]->count += binomial(rng_utils::rng);
+        unitProducts[1]->count += binomial(rng_utils::rng);
+        touched.push_back(unitReactants[0]->ID);
+        touched.push_back(unitProducts[0]->ID);
+        touched.push_back(unitProducts[1]->ID);
+    }
+
+    double getProductYield() const { return efficiency; }
+
     double calculateRate(double NAV) const
     {
         return rateConstant.value * unitReactants[0]->count;
@@ -155,26 +236,28 @@ protected:
  * @brief Initiation reaction (e.g., I + A ––> IA)
  * Reaction between a radical molecule and monomer to create a polymer.
  */
-class Initiation : public Reaction
+class Initiation final : public Reaction
 {
 public:
     static inline const std::string &TYPE = ReactionType::INITIATION;
-    Initiation(RateConstant rateConstant, Unit *unitReactant1, Unit *unitReactant2, PolymerTypeGroupPtr polyProduct)
-        : Reaction(rateConstant, 0, 2, 1, 0)
+    Initiation(RateConstant rateConstant, Unit *unitReactant1, Unit *unitReactant2, PolymerTypeGroupPtr polyProduct, PolymerPool *polymerPool_)
+        : Reaction(rateConstant, 0, 2, 1, 0), polymerPool(polymerPool_)
     {
         unitReactants[0] = unitReactant1; // initiator
         unitReactants[1] = unitReactant2; // monomer
         polyProducts[0] = polyProduct;
     };
 
-    void react()
+    void react(TouchedSpecies &touched)
     {
         --unitReactants[0]->count;
         --unitReactants[1]->count;
-        Polymer *polymer = new Polymer();
+        touched.push_back(unitReactants[0]->ID);
+        touched.push_back(unitReactants[1]->ID);
+        Polymer *polymer = polymerPool->acquire();
         polymer->addUnitToEnd((unitReactants[0])->ID);
         polymer->addUnitToEnd((unitReactants[1])->ID);
-        polyProducts[0]->insertPolymer(polymer);
+        polyProducts[0]->insertPolymer(polymer, touched);
     }
 
     double calculateRate(double NAV) const
@@ -183,13 +266,16 @@ public:
     }
 
     const std::string &getType() const { return TYPE; }
+
+private:
+    PolymerPool *polymerPool;
 };
 
 /**
  * @brief Propagation reaction (e.g., P[A,A] + B ––> P[A,B] + B).
  * Adds a monomer unit to the terminal chain end.
  */
-class Propagation : public Reaction
+class Propagation final : public Reaction
 {
 public:
     static inline const std::string &TYPE = ReactionType::PROPAGATION;
@@ -201,12 +287,13 @@ public:
         polyProducts[0] = polyProduct;
     }
 
-    void react()
+    void react(TouchedSpecies &touched)
     {
         --unitReactants[0]->count;
-        Polymer *polymer = polyReactants[0]->removeRandomPolymer();
+        touched.push_back(unitReactants[0]->ID);
+        Polymer *polymer = polyReactants[0]->removeRandomPolymer(touched);
         polymer->addUnitToEnd(unitReactants[0]->ID);
-        polyProducts[0]->insertPolymer(polymer);
+        polyProducts[0]->insertPolymer(polymer, touched);
     }
 
     double calculateRate(double NAV) const
@@ -221,7 +308,7 @@ public:
  * @brief Depropagation reaction (e.g., P[A,A] ––> P[?,A] + A).
  * Removes the terminal chain end unit.
  */
-class Depropagation : public Reaction
+class Depropagation final : public Reaction
 {
 public:
     static inline const std::string &TYPE = ReactionType::DEPROPAGATION;
@@ -233,15 +320,16 @@ public:
         unitProducts[0] = unitProduct;
     }
 
-    void react()
+    void react(TouchedSpecies &touched)
     {
         ++unitProducts[0]->count;
-        Polymer *polymer = polyReactants[0]->removeRandomPolymer();
+        touched.push_back(unitProducts[0]->ID);
+        Polymer *polymer = polyReactants[0]->removeRandomPolymer(touched);
         size_t dop_0 = polymer->getDegreeOfPolymerization();
         polymer->removeUnitFromEnd();
         size_t dop_1 = polymer->getDegreeOfPolymerization();
         assert(dop_0 - dop_1 == 1);
-        polyProducts[0]->insertPolymer(polymer);
+        polyProducts[0]->insertPolymer(polymer, touched);
     }
 
     double calculateRate(double NAV) const
@@ -256,7 +344,7 @@ public:
  * @brief Termination by disproportionation (e.g., P[A,A] + P[B,A] ––> D + D).
  *
  */
-class TerminationDisproportionation : public Reaction
+class TerminationDisproportionation final : public Reaction
 {
 public:
     static inline const std::string &TYPE = ReactionType::TERMINATION_D;
@@ -270,14 +358,14 @@ public:
         polyProducts[1] = polyProduct2;
     }
 
-    void react()
+    void react(TouchedSpecies &touched)
     {
-        Polymer *polymer1 = polyReactants[0]->removeRandomPolymer();
-        Polymer *polymer2 = polyReactants[1]->removeRandomPolymer();
+        Polymer *polymer1 = polyReactants[0]->removeRandomPolymer(touched);
+        Polymer *polymer2 = polyReactants[1]->removeRandomPolymer(touched);
         polymer1->terminateByDisproportionation();
         polymer2->terminateByDisproportionation();
-        polyProducts[0]->insertPolymer(polymer1);
-        polyProducts[1]->insertPolymer(polymer2);
+        polyProducts[0]->insertPolymer(polymer1, touched);
+        polyProducts[1]->insertPolymer(polymer2, touched);
     }
 
     double calculateRate(double NAV) const
@@ -295,7 +383,7 @@ private:
  * @brief Termination by combination (e.g., P[A,A] + P[B,A] ––> D).
  *
  */
-class TerminationCombination : public Reaction
+class TerminationCombination final : public Reaction
 {
 public:
     static inline const std::string &TYPE = ReactionType::TERMINATION_C;
@@ -308,12 +396,12 @@ public:
         polyProducts[0] = polyProduct1;
     }
 
-    void react()
+    void react(TouchedSpecies &touched)
     {
-        Polymer *polymer1 = polyReactants[0]->removeRandomPolymer();
-        Polymer *polymer2 = polyReactants[1]->removeRandomPolymer();
-        polymer1->terminateByCombination(polymer2);
-        polyProducts[0]->insertPolymer(polymer1);
+        Polymer *polymer1 = polyReactants[0]->removeRandomPolymer(touched);
+        Polymer *polymer2 = polyReactants[1]->removeRandomPolymer(touched);
+        polymer1->terminateByCombination(polymer2); // polymer2 is released with polymer1
+        polyProducts[0]->insertPolymer(polymer1, touched);
     }
 
     double calculateRate(double NAV) const
@@ -327,12 +415,12 @@ private:
     uint8_t sameReactant; // True = 1, False = 0
 };
 
-class ChainTransferToMonomer : public Reaction
+class ChainTransferToMonomer final : public Reaction
 {
 public:
     static inline const std::string &TYPE = ReactionType::CHAINTRANSFER_M;
-    ChainTransferToMonomer(RateConstant rateConstant, PolymerTypeGroupPtr polyReactant, Unit *unitReactant, PolymerTypeGroupPtr polyProduct1, PolymerTypeGroupPtr polyProduct2)
-        : Reaction(rateConstant, 1, 1, 2, 0)
+    ChainTransferToMonomer(RateConstant rateConstant, PolymerTypeGroupPtr polyReactant, Unit *unitReactant, PolymerTypeGroupPtr polyProduct1, PolymerTypeGroupPtr polyProduct2, PolymerPool *polymerPool_)
+        : Reaction(rateConstant, 1, 1, 2, 0), polymerPool(polymerPool_)
     {
         polyReactants[0] = polyReactant;
         unitReactants[0] = unitReactant;
@@ -340,17 +428,18 @@ public:
         polyProducts[1] = polyProduct2;
     }
 
-    void react()
+    void react(TouchedSpecies &touched)
     {
-        Polymer *polymer = polyReactants[0]->removeRandomPolymer();
+        Polymer *polymer = polyReactants[0]->removeRandomPolymer(touched);
         polymer->terminateByChainTransfer();
-        polyProducts[0]->insertPolymer(polymer);
+        polyProducts[0]->insertPolymer(polymer, touched);
         --unitReactants[0]->count;
+        touched.push_back(unitReactants[0]->ID);
 
         // Create a new monomer radical
-        Polymer *newRadical = new Polymer();
+        Polymer *newRadical = polymerPool->acquire();
         newRadical->addUnitToEnd((unitReactants[0])->ID);
-        polyProducts[1]->insertPolymer(newRadical);
+        polyProducts[1]->insertPolymer(newRadical, touched);
     }
 
     double calculateRate(double NAV) const
@@ -359,14 +448,17 @@ public:
     }
 
     const std::string &getType() const { return TYPE; }
+
+private:
+    PolymerPool *polymerPool;
 };
 
-class ThermalInitiationMonomer : public Reaction
+class ThermalInitiationMonomer final : public Reaction
 {
 public:
     static inline const std::string &TYPE = ReactionType::THERM_INIT_M;
-    ThermalInitiationMonomer(RateConstant rateConstant, Unit *unitReactant1, Unit *unitReactant2, Unit *unitReactant3, PolymerTypeGroupPtr polyProduct1, PolymerTypeGroupPtr polyProduct2)
-        : Reaction(rateConstant, 0, 3, 2, 0)
+    ThermalInitiationMonomer(RateConstant rateConstant, Unit *unitReactant1, Unit *unitReactant2, Unit *unitReactant3, PolymerTypeGroupPtr polyProduct1, PolymerTypeGroupPtr polyProduct2, PolymerPool *polymerPool_)
+        : Reaction(rateConstant, 0, 3, 2, 0), polymerPool(polymerPool_)
     {
         unitReactants[0] = unitReactant1;
         unitReactants[1] = unitReactant2;
@@ -375,19 +467,21 @@ public:
         polyProducts[1] = polyProduct2;
     }
 
-    void react()
+    void react(TouchedSpecies &touched)
     {
         --unitReactants[0]->count = unitReactants[0]->count;
         --unitReactants[1]->count = unitReactants[1]->count;
         --unitReactants[2]->count = unitReactants[2]->count;
+        for (size_t i = 0; i < unitReactants.size(); ++i)
+            touched.push_back(unitReactants[i]->ID);
 
-        Polymer *polymer1 = new Polymer();
+        Polymer *polymer1 = polymerPool->acquire();
         polymer1->addUnitToEnd((unitReactants[0])->ID);
-        polyProducts[0]->insertPolymer(polymer1);
+        polyProducts[0]->insertPolymer(polymer1, touched);
 
-        Polymer *polymer2 = new Polymer();
+        Polymer *polymer2 = polymerPool->acquire();
         polymer2->addUnitToEnd((unitReactants[0])->ID);
-        polyProducts[1]->insertPolymer(polymer2);
+        polyProducts[1]->insertPolymer(polymer2, touched);
     }
 
     double calculateRate(double NAV) const
@@ -396,6 +490,9 @@ public:
     }
 
     const std::string &getType() const { return TYPE; }
+
+private:
+    PolymerPool *polymerPool;
 };
 
 typedef std::unique_ptr<Reaction>
@@ -0,0 +1,170 @@
+#pragma once
+#include <algorithm>
+
+#include "common.h"
+#include "reactions/reactions.h"
+
+/**
+ * @brief Tau-leaping for unit-only reactions (hybrid mode).
+ * Reactions that only change unit counts (see Reaction::canLeap) and whose unit reactants all
+ * have at least `threshold` molecules are removed from exact selection. Between exact events
+ * they fire Poisson(rate * tau) times at once. The leap size tau follows the Cao-Gillespie-Petzold
+ * error control: the expected relative change of every leaped reactant over tau stays below epsilon.
+ */
+class TauLeaping
+{
+public:
+    TauLeaping() {};
+
+    TauLeaping(const std::vector<Reaction *> &reactions_, uint64_t threshold_, double epsilon_)
+        : reactions(reactions_), threshold(threshold_), epsilon(epsilon_)
+    {
+        leaping.assign(reactions.size(), 0);
+        rates.assign(reactions.size(), 0);
+        if (threshold == 0)
+            return;
+        for (size_t i = 0; i < reactions.size(); ++i)
+            if (reactions[i]->canLeap() && !reactions[i]->getUnitReactants().empty())
+                candidates.push_back(i);
+    }
+
+    bool isEnabled() const { return !candidates.empty(); }
+
+    bool isLeaping(size_t reactionIndex) const { return !leaping.empty() && leaping[reactionIndex]; }
+
+    /**
+     * @brief Re-evaluates which candidate reactions are leaped from their current reactant counts.
+     * Reactions that switched between exact and leaped simulation are appended to `changed`.
+     */
+    void classify(std::vector<size_t> &changed)
+    {
+        for (const auto &reactionIndex : candidates)
+        {
+            bool aboveThreshold = true;
+            for (const auto &unit : reactions[reactionIndex]->getUnitReactants())
+                aboveThreshold = aboveThreshold && unit->count >= threshold;
+
+            if (aboveThreshold != bool(leaping[reactionIndex]))
+            {
+                leaping[reactionIndex] = aboveThreshold;
+                rates[reactionIndex] = 0;
+                changed.push_back(reactionIndex);
+            }
+        }
+    }
+
+    void setRate(size_t reactionIndex, double rate) { rates[reactionIndex] = rate; }
+
+    double getTotalRate() const
+    {
+        double totalRate = 0;
+        for (const auto &reactionIndex : candidates)
+            if (leaping[reactionIndex])
+                totalRate += rates[reactionIndex];
+        return totalRate;
+    }
+
+    /**
+     * @brief Largest leap for which the mean and standard deviation of the change of every leaped
+     * reactant stay below max(epsilon * count / g, 1), where g is the highest order of the
+     * leaped reactions consuming it.
+     */
+    double selectTimeStep()
+    {
+        species.clear();
+
+        for (const auto &reactionIndex : candidates)
+        {
+            if (!leaping[reactionIndex])
+                continue;
+            for (const auto &unit : reactions[reactionIndex]->getUnitReactants())
+            {
+                auto it = std::find_if(species.begin(), species.end(), [unit](const LeapSpecies &s)
+                                       { return s.unit == unit; });
+                if (it == species.end())
+                    it = species.insert(species.end(), LeapSpecies{unit});
+                it->order = std::max(it->order, double(reactions[reactionIndex]->getUnitReactants().size()));
+            }
+        }
+
+        for (auto &s : species)
+        {
+            for (const auto &reactionIndex : candidates)
+            {
+                if (!leaping[reactionIndex])
+                    continue;
+                double change = getStoichiometry(reactions[reactionIndex], s.unit);
+                s.mean += change * rates[reactionIndex];
+                s.variance += change * change * rates[reactionIndex];
+            }
+        }
+
+        double tau = INFINITY;
+        for (const auto &s : species)
+        {
+            double bound = std::max(epsilon * s.unit->count / s.order, 1.0);
+            if (s.mean != 0)
+                tau = std::min(tau, bound / std::abs(s.mean));
+            if (s.variance != 0)
+                tau = std::min(tau, bound * bound / s.variance);
+        }
+        return tau;
+    }
+
+    /**
+     * @brief Fires every leaped reaction Poisson(rate * tau) times. The number of events is
+     * capped so that no reactant count can become negative.
+     */
+    void leap(double tau, TouchedSpecies &touched)
+    {
+        for (const auto &reactionIndex : candidates)
+        {
+            if (!leaping[reactionIndex] || rates[reactionIndex] == 0)
+                continue;
+
+            std::poisson_distribution<uint64_t> poisson(rates[reactionIndex] * tau);
+            uint64_t numEvents = poisson(rng_utils::rng);
+
+            Reaction *reaction = reactions[reactionIndex];
+            for (const auto &unit : reaction->getUnitReactants())
+            {
+                uint64_t multiplicity = std::count(reaction->getUnitReactants().begin(), reaction->getUnitReactants().end(), unit);
+                numEvents = std::min(numEvents, unit->count / multiplicity);
+            }
+
+            if (numEvents > 0)
+                reaction->leap(numEvents, touched);
+        }
+    }
+
+    uint64_t getThreshold() const { return threshold; }
+    double getEpsilon() const { return epsilon; }
+
+private:
+    std::vector<Reaction *> reactions;
+    std::vector<size_t> candidates; // Reactions that can be leaped (unit-only)
+    std::vector<uint8_t> leaping;   // Reaction index -> currently leaped
+    std::vector<double> rates;      // Reaction index -> rate while leaped
+
+    uint64_t threshold = 0;
+    double epsilon = 0.03;
+
+    struct LeapSpecies
+    {
+        const Unit *unit;
+        double order = 0;
+        double mean = 0;     // Expected change per unit time
+        double variance = 0; // Variance of the change per unit time
+    };
+    std::vector<LeapSpecies> species; // Scratch for selectTimeStep, reused across steps
+
+    // Expected change of a unit count per event of a reaction
+    static double getStoichiometry(const Reaction *reaction, const Unit *unit)
+    {
+        const auto &reactants = reaction->getUnitReactants();
+        const auto &products = reaction->getUnitProducts();
+        double change = -double(std::count(reactants.begin(), reactants.end(), unit));
+        change += reaction->getProductYield() * std::count(products.begin(), products.end(), unit);
+        return change;
+    }
+};
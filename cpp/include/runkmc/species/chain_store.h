@@ -0,0 +1,167 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "species/polymer.h"
+#include "species/sequence_arena.h"
+
+/**
+ * @brief Append-only, memory-mapped file of terminated chain sequences.
+ * Each record is a ChainRecord header followed by the chain's packed sequence words (see
+ * SequenceBuffer). Chains terminated by combination are stored as their two halves, as
+ * coupled in memory: the head words, then the words of the second half, which is read in
+ * reverse. Records are written through a sliding mapped window, so only the window
+ * is resident while the simulation runs; reads map the file read-only and scan it in order.
+ */
+class ChainStore
+{
+public:
+    static constexpr size_t WINDOW_SIZE = size_t(16) << 20; // Bytes mapped for writing at a time
+
+    struct ChainRecord
+    {
+        uint32_t length;        // Units of the head
+        uint32_t coupledLength; // Units of the second half (0 if not coupled)
+        SpeciesID typeID;       // PolymerType the chain was stored in
+        uint8_t state;          // PolymerState
+        uint8_t padding[6];
+    };
+
+    ChainStore(const std::string &filepath_) : filepath(filepath_)
+    {
+        fd = ::open(filepath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+            console::error("Could not create dead chain store " + filepath + ".");
+        pageSize = size_t(sysconf(_SC_PAGESIZE));
+    }
+
+    ChainStore(const ChainStore &) = delete;
+    ChainStore &operator=(const ChainStore &) = delete;
+
+    ~ChainStore()
+    {
+        unmapWindow();
+        if (fd >= 0)
+        {
+            // Drop the preallocated tail of the last window
+            if (::ftruncate(fd, off_t(writeOffset)) != 0)
+                console::warning("Could not truncate dead chain store " + filepath + ".");
+            ::close(fd);
+        }
+    }
+
+    void append(const Polymer &polymer, SpeciesID typeID)
+    {
+        const SequenceBuffer &head = polymer.getSequence();
+        const SequenceBuffer *tail = polymer.getCoupled() ? &polymer.getCoupled()->getSequence() : nullptr;
+        const size_t headWords = getNumWords(head.size());
+        const size_t tailWords = tail ? getNumWords(tail->size()) : 0;
+        const size_t bytes = sizeof(ChainRecord) + (headWords + tailWords) * sizeof(SequenceWord);
+        if (window == nullptr || writeOffset + bytes > windowStart + windowSize)
+            mapWindow(bytes);
+
+        char *target = window + (writeOffset - windowStart);
+        ChainRecord record{uint32_t(head.size()), uint32_t(tail ? tail->size() : 0), typeID, uint8_t(polymer.getState()), {}};
+        std::memcpy(target, &record, sizeof(ChainRecord));
+        target += sizeof(ChainRecord);
+        writeWords(target, head);
+        if (tail)
+            writeWords(target + headWords * sizeof(SequenceWord), *tail);
+
+        writeOffset += bytes;
+        ++numChains;
+    }
+
+    /**
+     * @brief Calls callback(record, words) for every stored chain, in the order they were appended.
+     * The words of the second half of a coupled chain follow the getNumWords(record.length) head words.
+     */
+    template <typename Func>
+    void forEachChain(Func callback) const
+    {
+        if (writeOffset == 0)
+            return;
+
+        void *mapping = ::mmap(nullptr, writeOffset, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED)
+            console::error("Could not map dead chain store " + filepath + " for reading.");
+        ::madvise(mapping, writeOffset, MADV_SEQUENTIAL);
+
+        const char *data = static_cast<const char *>(mapping);
+        size_t offset = 0;
+        while (offset < writeOffset)
+        {
+            ChainRecord record;
+            std::memcpy(&record, data + offset, sizeof(ChainRecord));
+            const SequenceWord *words = reinterpret_cast<const SequenceWord *>(data + offset + sizeof(ChainRecord));
+            callback(record, words);
+            offset += sizeof(ChainRecord) + (getNumWords(record.length) + getNumWords(record.coupledLength)) * sizeof(SequenceWord);
+        }
+
+        ::munmap(mapping, writeOffset);
+    }
+
+    uint64_t getNumChains() const { return numChains; }
+    size_t getNumBytes() const { return writeOffset; }
+
+    static size_t getNumWords(size_t length)
+    {
+        const size_t unitsPerWord = registry::SEQUENCE_CODEC.unitsPerWord;
+        return (length + unitsPerWord - 1) / unitsPerWord;
+    }
+
+private:
+    std::string filepath;
+    int fd = -1;
+    size_t pageSize;
+
+    char *window = nullptr;
+    size_t windowStart = 0; // File offset of the mapped window (page aligned)
+    size_t windowSize = 0;
+    size_t writeOffset = 0; // End of the last record
+    uint64_t numChains = 0;
+
+    void writeWords(char *target, const SequenceBuffer &sequence)
+    {
+        const size_t numWords = getNumWords(sequence.size());
+        std::memcpy(target, sequence.getWords(), numWords * sizeof(SequenceWord));
+
+        // Zero the unused fields of the last word so the file only depends on the sequence
+        const auto &codec = registry::SEQUENCE_CODEC;
+        const size_t usedFields = sequence.size() % codec.unitsPerWord;
+        if (usedFields != 0)
+        {
+            SequenceWord last;
+            char *lastWord = target + (numWords - 1) * sizeof(SequenceWord);
+            std::memcpy(&last, lastWord, sizeof(SequenceWord));
+            last &= (SequenceWord(1) << (usedFields * codec.bits)) - 1;
+            std::memcpy(lastWord, &last, sizeof(SequenceWord));
+        }
+    }
+
+    // Maps a new window starting at the page holding writeOffset, large enough for `bytes`
+    void mapWindow(size_t bytes)
+    {
+        unmapWindow();
+        windowStart = writeOffset - writeOffset % pageSize;
+        windowSize = writeOffset - windowStart + std::max(bytes, WINDOW_SIZE);
+        windowSize = (windowSize + pageSize - 1) / pageSize * pageSize;
+
+        if (::ftruncate(fd, off_t(windowStart + windowSize)) != 0)
+            console::error("Could not grow dead chain store " + filepath + ".");
+        void *mapping = ::mmap(nullptr, windowSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, off_t(windowStart));
+        if (mapping == MAP_FAILED)
+            console::error("Could not map dead chain store " + filepath + ".");
+        window = static_cast<char *>(mapping);
+    }
+
+    void unmapWindow()
+    {
+        if (window == nullptr)
+            return;
+        ::munmap(window, windowSize);
+        window = nullptr;
+    }
+};
@@ -0,0 +1,93 @@
+#pragma once
+#include "common.h"
+
+/**
+ * @brief Direct lookup from a packed end group to the index of a PolymerType within a group.
+ * End groups of up to MAX_LENGTH units are packed into a uint64_t key (one byte per SpeciesID)
+ * and stored in a small open-addressing hash table. Only usable when all end groups of the group
+ * have the same, non-zero length; otherwise the group falls back to scanning its types.
+ */
+class EndGroupTable
+{
+public:
+    static constexpr size_t MAX_LENGTH = sizeof(uint64_t) / sizeof(SpeciesID);
+    static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+    EndGroupTable() {};
+
+    /**
+     * @brief Builds the table from the end groups of every type in a group.
+     * If several types share an end group, the first one wins (as with a linear scan).
+     */
+    EndGroupTable(const std::vector<std::vector<SpeciesID>> &endGroups)
+    {
+        if (endGroups.empty())
+            return;
+        length = endGroups[0].size();
+        for (const auto &endGroup : endGroups)
+        {
+            if (endGroup.size() != length || length == 0 || length > MAX_LENGTH)
+            {
+                length = 0;
+                return;
+            }
+        }
+
+        size_t capacity = 4;
+        while (capacity < 2 * endGroups.size())
+            capacity <<= 1;
+        mask = capacity - 1;
+        keys.assign(capacity, 0);
+        values.assign(capacity, NOT_FOUND);
+
+        for (size_t i = 0; i < endGroups.size(); ++i)
+        {
+            uint64_t key = pack(endGroups[i].begin(), endGroups[i].end());
+            size_t slot = probe(key);
+            if (values[slot] == NOT_FOUND)
+            {
+                keys[slot] = key;
+                values[slot] = i;
+            }
+        }
+    }
+
+    bool isUsable() const { return length > 0; }
+
+    // Number of terminal units in the key
+    size_t getLength() const { return length; }
+
+    size_t find(uint64_t key) const { return values[probe(key)]; }
+
+    template <typename Iterator>
+    static uint64_t pack(Iterator begin, Iterator end)
+    {
+        uint64_t key = 0;
+        for (auto it = begin; it != end; ++it)
+            key = (key << (8 * sizeof(SpeciesID))) | uint64_t(*it);
+        return key;
+    }
+
+private:
+    size_t length = 0;
+    size_t mask = 0;
+    std::vector<uint64_t> keys;
+    std::vector<size_t> values;
+
+    static uint64_t hash(uint64_t key)
+    {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return key;
+    }
+
+    // Slot holding key, or the empty slot where it would be inserted
+    size_t probe(uint64_t key) const
+    {
+        size_t slot = hash(key) & mask;
+        while (values[slot] != NOT_FOUND && keys[slot] != key)
+            slot = (slot + 1) & mask;
+        return slot;
+    }
+};
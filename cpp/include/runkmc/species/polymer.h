@@ -1,21 +1,25 @@
 #pragma once
 #include "common.h"
 #include "analysis/utils.h"
+#include "species/end_group_table.h"
+#include "species/sequence_arena.h"
 
 class Polymer
 {
 private:
 	PolymerState state;
-	std::vector<analysis::SequenceStats> posStats;
-	std::vector<SpeciesID> sequence;
+	analysis::PositionalStats posStats;
+	SequenceBuffer sequence; // Inline for short chains, then blocks from the shared SequenceArena
 	SpeciesID initiator;
+	PolymerHandle handle; // Slot in the PolymerPool
+	Polymer *coupled = nullptr; // Second half of a chain terminated by combination (sequence read in reverse)
+	uint32_t *monomerCounts;    // Units of each monomer, without initiator fragments (NUM_MONOMERS values, owned by the PolymerPool)
 
 public:
-	Polymer(uint32_t maxDOP = 1000)
+	Polymer(SequenceArena *sequenceArena = nullptr, PolymerHandle handle_ = 0, uint32_t *monomerCounts_ = nullptr)
+		: sequence(sequenceArena), handle(handle_), monomerCounts(monomerCounts_)
 	{
-		sequence.reserve(maxDOP);
 		state = ALIVE;
-		posStats.reserve(NUM_BUCKETS);
 	};
 
 	~Polymer() = default;
@@ -27,6 +31,10 @@ public:
 	void addUnitToEnd(const SpeciesID unit)
 	{
 		sequence.push_back(unit);
+
+		const uint64_t code = registry::SEQUENCE_CODEC.encode(unit);
+		if (registry::SEQUENCE_CODEC.isMonomer(code))
+			++monomerCounts[code];
 	}
 
 	void removeUnitFromEnd()
@@ -36,13 +44,15 @@ public:
 		if (getDegreeOfPolymerization() <= 1)
 			console::error("Trying to remove last unit from polymer.");
 
+		const uint64_t code = sequence.getCode(sequence.size() - 1);
+		if (registry::SEQUENCE_CODEC.isMonomer(code))
+			--monomerCounts[code];
 		sequence.pop_back();
 	}
 
 	void clearSequence()
 	{
-		sequence.clear();
-		std::vector<SpeciesID>().swap(sequence);
+		sequence.release();
 	}
 
 	/***************** State functions *****************/
@@ -50,15 +60,37 @@ public:
 
 	bool isAlive() const { return state == PolymerState::ALIVE; }
 
-	size_t getDegreeOfPolymerization() const { return sequence.size(); }
+	bool isTerminated() const
+	{
+		return state == PolymerState::TERMINATED_D || state == PolymerState::TERMINATED_C || state == PolymerState::TERMINATED_CT;
+	}
+
+	size_t getDegreeOfPolymerization() const
+	{
+		if (coupled != nullptr)
+			return sequence.size() + coupled->sequence.size();
+		return sequence.size();
+	}
 
 	bool endGroupIs(const std::vector<SpeciesID> &endGroup) const
 	{
-		if (!isAlive() || endGroup.size() > getDegreeOfPolymerization() + 1)
+		if (!isAlive() || endGroup.size() > getDegreeOfPolymerization())
 			return false;
 		return equal(sequence.end() - endGroup.size(), sequence.end(), endGroup.begin());
 	}
 
+	/**
+	 * @brief Packs the last `length` units into a key (see EndGroupTable::pack).
+	 * Returns false if the polymer is not alive or shorter than length.
+	 */
+	bool packEndGroup(size_t length, uint64_t &key) const
+	{
+		if (!isAlive() || length > getDegreeOfPolymerization())
+			return false;
+		key = EndGroupTable::pack(sequence.end() - length, sequence.end());
+		return true;
+	}
+
 	bool isCompressed() const
 	{
 		if (sequence.empty() && !posStats.empty())
@@ -72,41 +104,89 @@ public:
 			return "";
 
 		std::string sequenceString;
-		for (const auto &id : sequence)
+		for (const SpeciesID &id : sequence)
 			sequenceString += std::to_string(id) + " ";
+		if (coupled != nullptr)
+			for (size_t i = coupled->sequence.size(); i-- > 0;)
+				sequenceString += std::to_string(coupled->sequence[i]) + " ";
 		return sequenceString;
 	}
 
+	analysis::PositionalStats calculatePositionalStats() const
+	{
+		if (coupled != nullptr)
+			return analysis::calculatePositionalSequenceStats(sequence, coupled->sequence, NUM_BUCKETS);
+		return analysis::calculatePositionalSequenceStats(sequence, NUM_BUCKETS);
+	}
+
+	/**
+	 * @brief Adds the positional stats of this chain to stats, read from the packed sequence in
+	 * place (or the stored stats of a compressed chain).
+	 */
+	void addPositionalStats(analysis::PositionalStats &stats) const
+	{
+		if (isCompressed())
+			stats += posStats;
+		else
+			analysis::addPositionalSequenceStats(sequence, coupled ? &coupled->sequence : nullptr, stats);
+	}
+
 	PolymerState getState() const { return state; }
 
-	const std::vector<SpeciesID> &getSequence() const { return sequence; }
+	// Monomer units of the chain, indexed by monomer code (see analysis::ChainMoments)
+	const uint32_t *getMonomerCounts() const { return monomerCounts; }
 
-	const std::vector<analysis::SequenceStats> &getPositionalStats() const { return posStats; }
+	PolymerHandle getHandle() const { return handle; }
 
-	/***************** Reaction functions *****************/
+	const SequenceBuffer &getSequence() const { return sequence; }
+
+	// Second half of the chain (read in reverse), or nullptr if the chain is not coupled
+	const Polymer *getCoupled() const { return coupled; }
 
-	void terminate()
+	/**
+	 * @brief Detaches the second half of a coupled chain and returns it (nullptr if none),
+	 * so that its owner can release it.
+	 */
+	Polymer *decouple()
 	{
-		posStats = analysis::calculatePositionalSequenceStats(sequence, NUM_BUCKETS);
+		Polymer *partner = coupled;
+		coupled = nullptr;
+		return partner;
+	}
+
+	const analysis::PositionalStats &getPositionalStats() const { return posStats; }
+
+	/**
+	 * @brief Replaces the sequence of a dead chain by its positional stats.
+	 * Done by the PolymerType that stores the chain (see PolymerType::insertPolymer).
+	 */
+	void compress()
+	{
+		posStats = calculatePositionalStats();
 		clearSequence();
 	}
 
+	/***************** Reaction functions *****************/
+
 	void terminateByChainTransfer()
 	{
 		state = PolymerState::TERMINATED_CT;
-		terminate();
 	}
 
 	void terminateByDisproportionation()
 	{
 		state = PolymerState::TERMINATED_D;
-		terminate();
 	}
 
+	/**
+	 * @brief Couples polymer to the end of this chain in O(1): its sequence is not copied but
+	 * read in reverse after this one. polymer stays owned by this chain until decouple().
+	 */
 	void terminateByCombination(Polymer *&polymer)
 	{
-		sequence.insert(sequence.end(), polymer->sequence.rbegin(), polymer->sequence.rend());
+		coupled = polymer;
+		for (size_t i = 0; i < registry::NUM_MONOMERS; ++i)
+			monomerCounts[i] += polymer->monomerCounts[i];
 		state = PolymerState::TERMINATED_C;
-		terminate();
 	}
 };
@@ -0,0 +1,101 @@
+#pragma once
+#include <algorithm>
+#include <new>
+
+#include "common.h"
+#include "species/polymer.h"
+#include "species/sequence_arena.h"
+
+/**
+ * @brief Slab allocator for Polymer objects.
+ * Polymers are constructed in place in fixed-size slabs, so allocation is O(1) and chains
+ * created one after another are contiguous in memory. Released polymers (e.g. the second chain
+ * of a termination by combination) are destroyed and their slots reused through a freelist.
+ * Every slot is identified by a 32-bit PolymerHandle (slab * SLAB_SIZE + index), which is
+ * what PolymerTypes store. Each slot also has NUM_MONOMERS monomer counts in a parallel slab,
+ * zeroed when the slot is handed out, so polymers track their composition without allocating.
+ * The pool also owns the SequenceArena that every polymer grows its sequence into.
+ */
+class PolymerPool
+{
+public:
+    static constexpr size_t SLAB_BITS = 12;
+    static constexpr size_t SLAB_SIZE = size_t(1) << SLAB_BITS;
+
+    PolymerPool() {};
+    PolymerPool(const PolymerPool &) = delete;
+    PolymerPool &operator=(const PolymerPool &) = delete;
+
+    ~PolymerPool()
+    {
+        // Destroy every polymer that was not already released
+        std::sort(freeList.begin(), freeList.end());
+        for (PolymerHandle handle = 0; handle < numSlots; ++handle)
+        {
+            if (!std::binary_search(freeList.begin(), freeList.end(), handle))
+                get(handle)->~Polymer();
+        }
+    }
+
+    Polymer *acquire()
+    {
+        PolymerHandle handle;
+        if (!freeList.empty())
+        {
+            handle = freeList.back();
+            freeList.pop_back();
+        }
+        else
+        {
+            if (numSlots == slabs.size() * SLAB_SIZE)
+            {
+                if (numSlots + SLAB_SIZE > size_t(std::numeric_limits<PolymerHandle>::max()) + 1)
+                    console::error("Too many polymers for 32-bit polymer handles.");
+                slabs.emplace_back(new Slot[SLAB_SIZE]);
+                countSlabs.emplace_back(new uint32_t[SLAB_SIZE * registry::NUM_MONOMERS]);
+            }
+            handle = PolymerHandle(numSlots++);
+        }
+        ++numLive;
+        uint32_t *monomerCounts = getMonomerCounts(handle);
+        std::fill(monomerCounts, monomerCounts + registry::NUM_MONOMERS, 0);
+        return new (getSlot(handle)) Polymer(&sequenceArena, handle, monomerCounts);
+    }
+
+    void release(Polymer *polymer)
+    {
+        PolymerHandle handle = polymer->getHandle();
+        polymer->~Polymer();
+        freeList.push_back(handle);
+        --numLive;
+    }
+
+    Polymer *get(PolymerHandle handle) const
+    {
+        return std::launder(reinterpret_cast<Polymer *>(getSlot(handle)));
+    }
+
+    size_t getNumLive() const { return numLive; }
+
+    const SequenceArena &getSequenceArena() const { return sequenceArena; }
+
+private:
+    typedef std::aligned_storage_t<sizeof(Polymer), alignof(Polymer)> Slot;
+
+    std::vector<std::unique_ptr<Slot[]>> slabs;
+    std::vector<std::unique_ptr<uint32_t[]>> countSlabs; // Monomer counts of the slots of each slab
+    size_t numSlots = 0;                 // Slots handed out so far (released ones included)
+    std::vector<PolymerHandle> freeList; // Released slots
+    size_t numLive = 0;
+    SequenceArena sequenceArena; // Destroyed after the polymers (see ~PolymerPool)
+
+    Slot *getSlot(PolymerHandle handle) const
+    {
+        return &slabs[handle >> SLAB_BITS][handle & (SLAB_SIZE - 1)];
+    }
+
+    uint32_t *getMonomerCounts(PolymerHandle handle) const
+    {
+        return &countSlabs[handle >> SLAB_BITS][(handle & (SLAB_SIZE - 1)) * registry::NUM_MONOMERS];
+    }
+};
@@ -1,10 +1,15 @@
 #pragma once
 #include "common.h"
 #include "polymer.h"
+#include "species/polymer_pool.h"
+#include "species/chain_store.h"
 #include "analysis/types.h"
+#include "utils/sum_tree.h"
+
+class PolymerTypeGroup;
 
 /**
- * @brief Stores pointers to polymer objects of a specific type.
+ * @brief Stores the handles of polymer objects of a specific type (see PolymerPool).
  * Type can infer the end group of the polymer objects but is not required to.
  *
  */
@@ -12,35 +17,133 @@ class PolymerType
 {
 public:
     std::string name;
+    SpeciesID ID;
     uint64_t count;
 
-    PolymerType(const std::string &name_, const std::vector<SpeciesID> &endGroup_) : name(name_), endGroup(endGroup_), count(0) {};
+    PolymerType(const std::string &name_, SpeciesID ID_, const std::vector<SpeciesID> &endGroup_) : name(name_), ID(ID_), endGroup(endGroup_), count(0) {};
 
     ~PolymerType() {};
 
     void insertPolymer(Polymer *polymer)
     {
         ++count;
-        polymers.push_back(polymer);
+        for (const auto &membership : groupMemberships)
+            membership.incrementCount();
+        moments.add(polymer->getMonomerCounts());
+
+        if (polymer->isTerminated() && storeDeadChain(polymer))
+            return;
+        if (polymer->isCompressed())
+        {
+            if (compressedStats.empty())
+                compressedStats = polymer->getPositionalStats();
+            else
+                compressedStats += polymer->getPositionalStats();
+        }
+        polymers.push_back(polymer->getHandle());
     }
 
     Polymer *removeRandomPolymer()
     {
+        if (polymers.empty())
+            console::error("Cannot remove a polymer from " + name + ": it holds no stored chains (dead chains are folded when dead_chains = stream or spill).");
         --count;
-        size_t randomIndex = int(rng_utils::dis(rng_utils::rng) * polymers.size());
-        Polymer *polymer = polymers[randomIndex];           // get random polymer
-        polymers[randomIndex] = std::move(polymers.back()); // swap
-        polymers.pop_back();                                // and pop!
+        for (const auto &membership : groupMemberships)
+            membership.decrementCount();
+        size_t randomIndex = int(rng_utils::uniform() * polymers.size());
+        PolymerHandle handle = polymers[randomIndex]; // get random polymer
+        polymers[randomIndex] = polymers.back();      // swap
+        polymers.pop_back();                          // and pop!
+
+        Polymer *polymer = polymerPool->get(handle);
+        moments.remove(polymer->getMonomerCounts());
+        if (polymer->isCompressed())
+            compressedStats -= polymer->getPositionalStats();
         return polymer;
     }
 
-    const std::vector<Polymer *> &getPolymers() const { return polymers; }
+    const std::vector<PolymerHandle> &getPolymers() const { return polymers; }
+
+    void setPolymerPool(PolymerPool *polymerPool_) { polymerPool = polymerPool_; }
 
     const std::vector<SpeciesID> &getEndGroup() const { return endGroup; }
 
+    /**
+     * @brief Folds terminated chains inserted from now on into running aggregates and releases
+     * them to the pool instead of storing them. If chainStore_ is given, their sequences are
+     * also appended to it.
+     */
+    void enableStreaming(ChainStore *chainStore_ = nullptr)
+    {
+        streamDeadChains = true;
+        chainStore = chainStore_;
+        foldedChains = analysis::ChainAggregate(NUM_BUCKETS);
+        foldStats = analysis::PositionalStats(NUM_BUCKETS);
+    }
+
+    const analysis::ChainAggregate &getFoldedChains() const { return foldedChains; }
+
+    // Moments of every chain of this type, folded chains included
+    const analysis::ChainMoments &getMoments() const { return moments; }
+
+    // Summed positional stats of the stored compressed chains (empty if there are none yet)
+    const analysis::PositionalStats &getCompressedStats() const { return compressedStats; }
+
+    /**
+     * @brief Registers a group containing this type so count changes are propagated to it.
+     *
+     * @param group PolymerTypeGroup containing this type
+     * @param typeIndex index of this type within the group
+     */
+    void addGroupMembership(PolymerTypeGroup *group, size_t typeIndex)
+    {
+        groupMemberships.push_back(GroupMembership{group, typeIndex});
+    }
+
 private:
-    std::vector<Polymer *> polymers;
-    std::vector<SpeciesID> endGroup; // endGroup to identify the terminal units on the chain end.
+    struct GroupMembership
+    {
+        PolymerTypeGroup *group;
+        size_t typeIndex;
+        void incrementCount() const;
+        void decrementCount() const;
+    };
+
+    std::vector<PolymerHandle> polymers;
+    std::vector<SpeciesID> endGroup;               // endGroup to identify the terminal units on the chain end.
+    std::vector<GroupMembership> groupMemberships; // Every group containing this type
+
+    PolymerPool *polymerPool = nullptr;        // Pool the handles refer to
+    bool streamDeadChains = false;             // Fold dead chains instead of storing them
+    ChainStore *chainStore = nullptr;          // Set when dead chain sequences are spilled to disk
+    analysis::ChainAggregate foldedChains;     // Terminated chains folded in (streaming only)
+    analysis::PositionalStats foldStats;       // Scratch for the stats of the chain being folded
+    analysis::ChainMoments moments;            // Updated on every insert and remove
+    analysis::PositionalStats compressedStats; // Sum over the stored compressed chains
+
+    // Compresses a dead chain, or folds it into the aggregates and releases it when streaming.
+    // Returns true if the chain was released.
+    bool storeDeadChain(Polymer *polymer)
+    {
+        if (!streamDeadChains)
+        {
+            if (!polymer->isCompressed())
+                polymer->compress();
+            if (Polymer *partner = polymer->decouple())
+                polymerPool->release(partner);
+            return false;
+        }
+
+        foldStats.clear();
+        polymer->addPositionalStats(foldStats);
+        foldedChains.addChain(foldStats);
+        if (chainStore != nullptr)
+            chainStore->append(*polymer, ID);
+        if (Polymer *partner = polymer->decouple())
+            polymerPool->release(partner);
+        polymerPool->release(polymer);
+        return true;
+    }
 };
 
 typedef PolymerType *PolymerTypePtr;
@@ -60,23 +163,28 @@ public:
         : name(name_), polymerTypePtrs(polymerTypePtrs_)
     {
         polymerTypeCounts.resize(polymerTypePtrs_.size());
+
+        std::vector<std::vector<SpeciesID>> endGroups;
+        for (const auto &polymerType : polymerTypePtrs)
+            endGroups.push_back(polymerType->getEndGroup());
+        endGroupTable = EndGroupTable(endGroups);
     };
 
     ~PolymerTypeGroup() {}
 
-    Polymer *removeRandomPolymer()
+    // Group counts are kept up to date by the member PolymerType objects (see addGroupMembership)
+    Polymer *removeRandomPolymer(TouchedSpecies &touched)
     {
         if (polymerTypePtrs.size() == 1)
         {
-            --count;
-            --polymerTypeCounts[0];
+            touched.push_back(polymerTypePtrs[0]->ID);
             return polymerTypePtrs[0]->removeRandomPolymer();
         }
 
-        std::discrete_distribution<size_t> discrete_dis(polymerTypeCounts.begin(), polymerTypeCounts.end());
-        size_t typeIndex = discrete_dis(rng_utils::rng);
-        --count;
-        --polymerTypeCounts[typeIndex];
+        // Pick a type proportionally to its count
+        uint64_t target = std::min(uint64_t(rng_utils::uniform() * count), count - 1);
+        size_t typeIndex = polymerTypeCounts.find(target);
+        touched.push_back(polymerTypePtrs[typeIndex]->ID);
         return polymerTypePtrs[typeIndex]->removeRandomPolymer();
     }
 
@@ -86,27 +194,40 @@ public:
      * is no classification and the pointer is directly stored.
      *
      * @param Polymer* polymer
+     * @param TouchedSpecies& touched receives the ID of the PolymerType the polymer was stored in
      */
-    void insertPolymer(Polymer *polymer)
+    void insertPolymer(Polymer *polymer, TouchedSpecies &touched)
     {
         // No classification needed. Directly store the polymer.
         if (polymerTypePtrs.size() == 1)
         {
-            ++count;
-            ++polymerTypeCounts[0];
+            touched.push_back(polymerTypePtrs[0]->ID);
             polymerTypePtrs[0]->insertPolymer(polymer);
             return;
         }
 
-        // Classify the polymer based on its end group.
+        // Classify the polymer based on its end group with a single table lookup.
+        if (endGroupTable.isUsable())
+        {
+            uint64_t key;
+            size_t typeIndex = EndGroupTable::NOT_FOUND;
+            if (polymer->packEndGroup(endGroupTable.getLength(), key))
+                typeIndex = endGroupTable.find(key);
+            if (typeIndex == EndGroupTable::NOT_FOUND)
+                console::error("End sequence for inserted polymer does not match. Exiting.....");
+            touched.push_back(polymerTypePtrs[typeIndex]->ID);
+            polymerTypePtrs[typeIndex]->insertPolymer(polymer);
+            return;
+        }
+
+        // Mixed or empty end groups: scan the types in order.
         for (int i = 0; i < polymerTypePtrs.size(); ++i)
         {
             // console::log("PolyType" + polymerTypePtrs[i]->name);
             if (polymer->endGroupIs(polymerTypePtrs[i]->getEndGroup()))
             {
                 // console::log("PolymerType match!");
-                ++count;
-                ++polymerTypeCounts[i];
+                touched.push_back(polymerTypePtrs[i]->ID);
                 polymerTypePtrs[i]->insertPolymer(polymer);
                 return;
             }
@@ -116,14 +237,20 @@ public:
 
     void updatePolymerCounts()
     {
-        uint64_t totalCount = 0;
+        std::vector<uint64_t> typeCounts(polymerTypePtrs.size());
         for (size_t i = 0; i < polymerTypePtrs.size(); ++i)
-        {
-            uint64_t typeCount = polymerTypePtrs[i]->count;
-            polymerTypeCounts[i] = typeCount;
-            totalCount += typeCount;
-        }
-        count = totalCount;
+            typeCounts[i] = polymerTypePtrs[i]->count;
+        polymerTypeCounts.build(typeCounts);
+        count = polymerTypeCounts.total();
+    }
+
+    /**
+     * @brief Applies a change in the count of the member type at typeIndex.
+     */
+    void addToCount(size_t typeIndex, int64_t delta)
+    {
+        polymerTypeCounts.update(typeIndex, polymerTypeCounts.get(typeIndex) + delta);
+        count += delta;
     }
 
     const std::vector<PolymerTypePtr> &getPolymerTypes() const { return polymerTypePtrs; }
@@ -135,9 +262,13 @@ public:
 
 private:
     std::vector<PolymerTypePtr> polymerTypePtrs;
-    std::vector<uint64_t> polymerTypeCounts;
+    SumTree<uint64_t> polymerTypeCounts; // Count of every member type for O(log k) weighted selection
+    EndGroupTable endGroupTable;         // Packed end group -> type index
 };
 
+inline void PolymerType::GroupMembership::incrementCount() const { group->addToCount(typeIndex, 1); }
+inline void PolymerType::GroupMembership::decrementCount() const { group->addToCount(typeIndex, -1); }
+
 struct PolymerGroupStruct
 {
     std::string name;
@@ -0,0 +1,209 @@
+#pragma once
+#include <cstring>
+#include <iterator>
+
+#include "common.h"
+
+typedef uint64_t SequenceWord;
+
+/**
+ * @brief Shared storage for polymer sequences.
+ * Blocks of packed sequence words are handed out in power-of-two size classes from large
+ * segments and recycled through one freelist per size class, so memory grows with the number
+ * of units actually incorporated into chains instead of with the number of chains.
+ */
+class SequenceArena
+{
+public:
+    static constexpr size_t SEGMENT_SIZE = size_t(1) << 13; // Words per segment (64 KiB)
+    static constexpr size_t NUM_SIZE_CLASSES = 48;
+
+    SequenceArena() {};
+    SequenceArena(const SequenceArena &) = delete;
+    SequenceArena &operator=(const SequenceArena &) = delete;
+
+    /**
+     * @brief Returns a block of `capacity` words. capacity must be a power of two.
+     */
+    SequenceWord *allocate(size_t capacity)
+    {
+        auto &freeList = freeLists[getSizeClass(capacity)];
+        if (!freeList.empty())
+        {
+            SequenceWord *block = freeList.back();
+            freeList.pop_back();
+            return block;
+        }
+
+        // Blocks larger than a segment get a dedicated segment
+        if (capacity > SEGMENT_SIZE)
+        {
+            segments.emplace_back(new SequenceWord[capacity]);
+            return segments.back().get();
+        }
+
+        if (segments.empty() || segmentPosition + capacity > SEGMENT_SIZE)
+        {
+            recycleSegmentTail();
+            segments.emplace_back(new SequenceWord[SEGMENT_SIZE]);
+            currentSegment = segments.back().get();
+            segmentPosition = 0;
+        }
+
+        SequenceWord *block = currentSegment + segmentPosition;
+        segmentPosition += capacity;
+        return block;
+    }
+
+    void deallocate(SequenceWord *block, size_t capacity)
+    {
+        freeLists[getSizeClass(capacity)].push_back(block);
+    }
+
+    static size_t getSizeClass(size_t capacity)
+    {
+        size_t sizeClass = 0;
+        while ((size_t(1) << sizeClass) < capacity)
+            ++sizeClass;
+        return sizeClass;
+    }
+
+private:
+    std::vector<std::unique_ptr<SequenceWord[]>> segments;
+    std::vector<SequenceWord *> freeLists[NUM_SIZE_CLASSES];
+    SequenceWord *currentSegment = nullptr;
+    size_t segmentPosition = SEGMENT_SIZE;
+
+    // Splits the unused end of the current segment into power-of-two blocks for reuse
+    void recycleSegmentTail()
+    {
+        if (currentSegment == nullptr)
+            return;
+        while (segmentPosition < SEGMENT_SIZE)
+        {
+            size_t remaining = SEGMENT_SIZE - segmentPosition;
+            size_t sizeClass = getSizeClass(remaining + 1) - 1; // Largest power of two <= remaining
+            deallocate(currentSegment + segmentPosition, size_t(1) << sizeClass);
+            segmentPosition += size_t(1) << sizeClass;
+        }
+    }
+};
+
+/**
+ * @brief Growable, bit-packed sequence of SpeciesIDs.
+ * Units are stored as registry::SEQUENCE_CODEC codes, several per 64-bit word. Short chains
+ * (oligomers) fit in an inline buffer; longer chains move to blocks from a SequenceArena,
+ * doubling in size as they grow.
+ */
+class SequenceBuffer
+{
+public:
+    static constexpr size_t INLINE_WORDS = 2;
+
+    class const_iterator
+    {
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef SpeciesID value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const SpeciesID *pointer;
+        typedef SpeciesID reference;
+
+        const_iterator(const SequenceBuffer *buffer_, size_t index_) : buffer(buffer_), index(index_) {};
+
+        SpeciesID operator*() const { return (*buffer)[index]; }
+        const_iterator &operator++()
+        {
+            ++index;
+            return *this;
+        }
+        const_iterator &operator--()
+        {
+            --index;
+            return *this;
+        }
+        const_iterator operator-(size_t n) const { return const_iterator(buffer, index - n); }
+        bool operator==(const const_iterator &other) const { return index == other.index; }
+        bool operator!=(const const_iterator &other) const { return index != other.index; }
+
+    private:
+        const SequenceBuffer *buffer;
+        size_t index;
+    };
+
+    SequenceBuffer(SequenceArena *arena_ = nullptr) : arena(arena_) {};
+    SequenceBuffer(const SequenceBuffer &) = delete;
+    SequenceBuffer &operator=(const SequenceBuffer &) = delete;
+
+    ~SequenceBuffer() { release(); }
+
+    void push_back(SpeciesID id)
+    {
+        const auto &codec = registry::SEQUENCE_CODEC;
+        size_t word = length / codec.unitsPerWord;
+        size_t shift = (length % codec.unitsPerWord) * codec.bits;
+        if (word == capacity)
+            grow(2 * capacity);
+
+        // Clear the field first; pop_back leaves stale bits behind
+        SequenceWord &target = words()[word];
+        target = (target & ~(codec.fieldMask << shift)) | (codec.encode(id) << shift);
+        ++length;
+    }
+
+    void pop_back() { --length; }
+
+    // Frees the storage and returns to the empty inline state
+    void release()
+    {
+        if (!isInline())
+            arena->deallocate(storage.heap, capacity);
+        length = 0;
+        capacity = INLINE_WORDS;
+    }
+
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+
+    SpeciesID operator[](size_t i) const { return registry::SEQUENCE_CODEC.decode(getCode(i)); }
+    SpeciesID back() const { return (*this)[length - 1]; }
+
+    uint64_t getCode(size_t i) const
+    {
+        const auto &codec = registry::SEQUENCE_CODEC;
+        return (words()[i / codec.unitsPerWord] >> ((i % codec.unitsPerWord) * codec.bits)) & codec.fieldMask;
+    }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, length); }
+
+    // Packed words holding the sequence; unit i is field (i % unitsPerWord) of word (i / unitsPerWord)
+    const SequenceWord *getWords() const { return words(); }
+
+private:
+    union Storage
+    {
+        SequenceWord inlineWords[INLINE_WORDS];
+        SequenceWord *heap;
+    } storage;
+    uint32_t length = 0;             // Units
+    uint32_t capacity = INLINE_WORDS; // Words
+    SequenceArena *arena;
+
+    bool isInline() const { return capacity <= INLINE_WORDS; }
+
+    SequenceWord *words() { return isInline() ? storage.inlineWords : storage.heap; }
+    const SequenceWord *words() const { return isInline() ? storage.inlineWords : storage.heap; }
+
+    void grow(size_t newCapacity)
+    {
+        if (arena == nullptr)
+            console::error("Polymer sequence has no arena to grow into.");
+        SequenceWord *block = arena->allocate(newCapacity);
+        std::memcpy(block, words(), capacity * sizeof(SequenceWord));
+        if (!isInline())
+            arena->deallocate(storage.heap, capacity);
+        storage.heap = block;
+        capacity = uint32_t(newCapacity);
+    }
+};
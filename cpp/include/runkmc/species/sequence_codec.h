@@ -0,0 +1,94 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "core/types.h"
+
+/**
+ * @brief Maps unit SpeciesIDs to dense fixed-width codes for bit-packed sequences.
+ * Monomers get codes 0..numMonomers-1 in MONOMER_IDS order, so the code of a monomer is also its
+ * monomer index. All other units (initiators, generic units) follow. The width is the smallest
+ * power of two (1, 2, 4 or 8 bits) holding every code, so a code never straddles two words.
+ * Until built the codec is the identity on 8-bit fields.
+ */
+struct SequenceCodec
+{
+    static constexpr size_t WORD_BITS = 64;
+
+    size_t bits = 8;
+    size_t unitsPerWord = WORD_BITS / 8;
+    size_t numMonomers = 0;
+    size_t numCodes = 256;
+    uint64_t fieldMask = 0xFF;
+    uint64_t lowBits = 0x0101010101010101ULL; // Lowest bit of every field
+
+    std::array<uint8_t, 256> codes; // SpeciesID -> code
+    std::array<SpeciesID, 256> ids; // code -> SpeciesID
+
+    SequenceCodec()
+    {
+        for (size_t i = 0; i < 256; ++i)
+            codes[i] = ids[i] = uint8_t(i);
+    }
+
+    SequenceCodec(const std::vector<SpeciesID> &monomerIDs, const std::vector<SpeciesID> &unitIDs) : SequenceCodec()
+    {
+        numMonomers = monomerIDs.size();
+        numCodes = 0;
+        for (const auto &id : monomerIDs)
+            addCode(id);
+        for (const auto &id : unitIDs)
+            if (std::find(monomerIDs.begin(), monomerIDs.end(), id) == monomerIDs.end())
+                addCode(id);
+
+        bits = 1;
+        while ((size_t(1) << bits) < numCodes)
+            bits *= 2;
+        unitsPerWord = WORD_BITS / bits;
+        fieldMask = (bits == WORD_BITS) ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+        lowBits = 0;
+        for (size_t i = 0; i < unitsPerWord; ++i)
+            lowBits |= uint64_t(1) << (i * bits);
+    }
+
+    uint64_t encode(SpeciesID id) const { return codes[id]; }
+    SpeciesID decode(uint64_t code) const { return ids[code]; }
+    bool isMonomer(uint64_t code) const { return code < numMonomers; }
+
+    // Code repeated in every field of a word
+    uint64_t broadcast(uint64_t code) const { return code * lowBits; }
+
+    // Low bit of every field of x that is zero
+    uint64_t zeroFields(uint64_t x) const
+    {
+        for (size_t shift = 1; shift < bits; shift *= 2)
+            x |= x >> shift;
+        return ~x & lowBits;
+    }
+
+    // Reverses the order of the fields of x
+    uint64_t reverseFields(uint64_t x) const
+    {
+        x = __builtin_bswap64(x);
+        if (bits < 8)
+            x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+        if (bits < 4)
+            x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+        if (bits < 2)
+            x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+        return x;
+    }
+
+    // Low bit of every field of x equal to code
+    uint64_t matchFields(uint64_t x, uint64_t code) const { return zeroFields(x ^ broadcast(code)); }
+
+private:
+    void addCode(SpeciesID id)
+    {
+        codes[id] = uint8_t(numCodes);
+        ids[numCodes] = id;
+        ++numCodes;
+    }
+};
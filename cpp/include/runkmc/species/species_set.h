@@ -1,7 +1,9 @@
 #pragma once
 #include "common.h"
 #include "species/polymer_type.h"
+#include "species/polymer_pool.h"
 #include "kmc/state.h"
+#include "kmc/config.h"
 
 class SpeciesSet
 {
@@ -55,21 +57,83 @@ public:
             polymerGroups.push_back(PolymerTypeGroup(polymerGroup.name, polymerSubTypePtrs));
             polymerGroupPtrs.push_back(&polymerGroups.back());
         }
+
+        for (auto &polymerType : polymerTypes)
+            polymerType.setPolymerPool(polymerPool.get());
+
+        // Type -> group membership index so count changes of a type reach every group containing it
+        for (auto &polymerGroup : polymerGroups)
+        {
+            const auto &groupTypes = polymerGroup.getPolymerTypes();
+            for (size_t i = 0; i < groupTypes.size(); ++i)
+                groupTypes[i]->addGroupMembership(&polymerGroup, i);
+        }
     };
 
+    /**
+     * @brief Recalculates all group counts from the member type counts. Group counts are
+     * maintained incrementally during the simulation, so this is only needed for a full resync.
+     */
     void updatePolyTypeGroups()
     {
         for (const auto &polymerGroupPtr : polymerGroupPtrs)
             polymerGroupPtr->updatePolymerCounts();
     };
 
+    /**
+     * @brief Applies the dead_chains mode to every PolymerType. storePath is the file of the
+     * dead chain store (spill mode only).
+     */
+    void setDeadChainMode(config::DeadChainMode mode, const std::string &storePath)
+    {
+        if (mode == config::DeadChainMode::RETAIN)
+            return;
+        if (mode == config::DeadChainMode::SPILL)
+            chainStore = std::make_unique<ChainStore>(storePath);
+        for (auto &polymerType : polymerTypes)
+            polymerType.enableStreaming(chainStore.get());
+    }
+
+    /**
+     * @brief Sum of the aggregates of all chains folded in by streaming PolymerTypes.
+     */
+    analysis::ChainAggregate getFoldedChains() const
+    {
+        analysis::ChainAggregate foldedChains;
+        for (const auto &polymerType : polymerTypes)
+            foldedChains += polymerType.getFoldedChains();
+        return foldedChains;
+    }
+
+    /**
+     * @brief Summed positional stats of the compressed chains of every PolymerType.
+     */
+    analysis::PositionalStats getCompressedStats() const
+    {
+        analysis::PositionalStats compressedStats(NUM_BUCKETS);
+        for (const auto &polymerType : polymerTypes)
+            if (!polymerType.getCompressedStats().empty())
+                compressedStats += polymerType.getCompressedStats();
+        return compressedStats;
+    }
+
+    /**
+     * @brief Chain length and molecular weight moments of all chains, summed over the PolymerTypes.
+     */
+    analysis::ChainMoments getChainMoments() const
+    {
+        analysis::ChainMoments moments;
+        for (const auto &polymerType : polymerTypes)
+            moments += polymerType.getMoments();
+        return moments;
+    }
+
     SpeciesState getStateData() const
     {
         SpeciesState data;
 
         // Unit counts / conversions
-        auto unitIDs = registry::getAllUnitIDs();
-        for (auto &id : unitIDs)
+        for (const auto &id : registry::UNIT_IDS)
         {
             data.unitCounts.push_back(units[id].count);
             data.unitConversions.push_back(units[id].calculateConversion());
@@ -104,42 +168,17 @@ public:
         return numerator / denominator;
     };
 
-    std::vector<Polymer *> getPolymers() const
+    /**
+     * @brief Calls callback(polymer) for every stored polymer, type by type, without copying.
+     */
+    template <typename Func>
+    void forEachPolymer(Func callback) const
     {
-
-        std::vector<Polymer *> polymers;
-
-        // Reserve space for all polymers
-        uint64_t numPolymers = 0;
         for (const auto &polymerType : polymerTypes)
-            numPolymers += polymerType.count;
-        polymers.reserve(numPolymers);
-
-        // Add all polymer pointers to the reserved space
-        for (const auto &polymerType : polymerTypes)
-        {
-            const auto &typePolymers = polymerType.getPolymers();
-            polymers.insert(polymers.end(), typePolymers.begin(), typePolymers.end());
-        }
-        return polymers;
+            for (const auto &handle : polymerType.getPolymers())
+                callback(*polymerPool->get(handle));
     }
 
-    analysis::RawSequenceData getRawSequenceData() const
-    {
-        const auto &polymers = getPolymers();
-        auto sequenceData = analysis::RawSequenceData(polymers.size());
-
-        for (const auto *polymer : polymers)
-        {
-            if (!polymer->isCompressed())
-                sequenceData.sequences.push_back(polymer->getSequence());
-            else
-                sequenceData.precomputedStats.push_back(polymer->getPositionalStats());
-        }
-
-        return sequenceData;
-    };
-
     void printSummary() const
     {
         console::log("Units:");
@@ -164,6 +203,9 @@ public:
         return monomerFWs;
     }
 
+    const std::vector<PolymerType> &getPolymerTypes() const { return polymerTypes; }
+    PolymerPool *getPolymerPool() const { return polymerPool.get(); }
+    const ChainStore *getChainStore() const { return chainStore.get(); }
     std::vector<Unit> &getUnits() { return units; }
     const std::vector<Unit> &getUnits() const { return units; }
     std::vector<PolymerTypeGroup> &getPolyTypeGroups() { return polymerGroups; }
@@ -177,6 +219,10 @@ private:
     std::vector<PolymerTypeGroup> polymerGroups;
     std::vector<PolymerTypeGroupPtr> polymerGroupPtrs;
 
+    // Owns every Polymer object. Held by pointer so its address survives moving the SpeciesSet.
+    std::unique_ptr<PolymerPool> polymerPool = std::make_unique<PolymerPool>();
+    std::unique_ptr<ChainStore> chainStore; // Dead chain sequences (dead_chains = spill)
+
     std::vector<Unit> units;
     size_t numParticles;
     double NAV;
@@ -0,0 +1,90 @@
+#pragma once
+#include <vector>
+
+/**
+ * @brief Binary min-heap over a fixed set of items identified by their index.
+ * Keeps the position of every item in the heap, so the key of any item can be
+ * changed in O(log n) and the item with the smallest key is available in O(1).
+ */
+template <typename T>
+class IndexedMinHeap
+{
+public:
+    IndexedMinHeap() {};
+
+    /**
+     * @brief Rebuilds the heap from a vector of keys in O(n).
+     */
+    void build(const std::vector<T> &keys_)
+    {
+        keys = keys_;
+        heap.resize(keys.size());
+        position.resize(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            heap[i] = i;
+            position[i] = i;
+        }
+        for (size_t i = heap.size() / 2; i-- > 0;)
+            siftDown(i);
+    }
+
+    void update(size_t index, T key)
+    {
+        T oldKey = keys[index];
+        keys[index] = key;
+        if (key < oldKey)
+            siftUp(position[index]);
+        else
+            siftDown(position[index]);
+    }
+
+    size_t top() const { return heap[0]; }
+    T topKey() const { return keys[heap[0]]; }
+    T get(size_t index) const { return keys[index]; }
+    size_t size() const { return heap.size(); }
+    bool empty() const { return heap.empty(); }
+
+private:
+    std::vector<T> keys;         // Item index -> key
+    std::vector<size_t> heap;    // Heap slot -> item index
+    std::vector<size_t> position; // Item index -> heap slot
+
+    void swapSlots(size_t a, size_t b)
+    {
+        std::swap(heap[a], heap[b]);
+        position[heap[a]] = a;
+        position[heap[b]] = b;
+    }
+
+    void siftUp(size_t slot)
+    {
+        while (slot > 0)
+        {
+            size_t parent = (slot - 1) / 2;
+            if (!(keys[heap[slot]] < keys[heap[parent]]))
+                break;
+            swapSlots(slot, parent);
+            slot = parent;
+        }
+    }
+
+    void siftDown(size_t slot)
+    {
+        size_t n = heap.size();
+        while (true)
+        {
+            size_t smallest = slot;
+            size_t left = 2 * slot + 1;
+            size_t right = left + 1;
+            if (left < n && keys[heap[left]] < keys[heap[smallest]])
+                smallest = left;
+            if (right < n && keys[heap[right]] < keys[heap[smallest]])
+                smallest = right;
+            if (smallest == slot)
+                break;
+            swapSlots(slot, smallest);
+            slot = smallest;
+        }
+    }
+};
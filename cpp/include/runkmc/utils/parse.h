@@ -173,6 +173,25 @@ namespace input
         }
     }
 
+    /**
+     * @brief Read an unsigned integer variable (accepts scientific notation, e.g. 1e5).
+     *
+     * @param strings list of variable strings ("name"=value)
+     * @param variableName name of variable to be read
+     * @param variable reference to variable to be overwritten
+     */
+    static void readVariable(const std::vector<std::string> &strings, const std::string &variableName, uint64_t &variable)
+    {
+        for (const auto &string : strings)
+        {
+            if (str::startswith(string, variableName))
+            {
+                std::vector<std::string> var = input::parseVariable(string);
+                variable = static_cast<uint64_t>(std::stod(var[1]));
+            }
+        }
+    }
+
     /**
      * @brief Read a required string variable.
      *
@@ -1,10 +1,251 @@
 #pragma once
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <random>
+#include <string>
 
 namespace rng_utils
 {
-    extern const int SEED = 1998; // Shoutout!
-    static std::random_device rd;
-    static std::mt19937 rng(SEED);
-    static std::uniform_real_distribution<double> dis(0.0, 1.0);
-}
\ No newline at end of file
+    inline constexpr uint64_t DEFAULT_SEED = 1998; // Shoutout!
+
+    /**
+     * @brief SplitMix64, used to expand a single 64-bit seed into generator states.
+     */
+    inline uint64_t splitmix64(uint64_t &state)
+    {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    inline constexpr uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    /**
+     * @brief Philox4x32-10 counter-based generator (Salmon et al., Random123).
+     * Every output block is a pure function of (key, counter), so independent streams need no
+     * shared state: the key is the seed and the 128-bit counter is split into a 64-bit block
+     * index, a stream ID and a replica ID. Two streams with different (seed, replica, stream)
+     * never overlap.
+     */
+    class Philox4x32
+    {
+    public:
+        typedef uint64_t result_type;
+
+        Philox4x32(uint64_t seed_ = DEFAULT_SEED, uint32_t replica_ = 0, uint32_t stream_ = 0)
+        {
+            key[0] = uint32_t(seed_);
+            key[1] = uint32_t(seed_ >> 32);
+            counter[0] = counter[1] = 0;
+            counter[2] = stream_;
+            counter[3] = replica_;
+        }
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+        result_type operator()()
+        {
+            if (index == 4)
+            {
+                generateBlock(counter, key, block);
+                if (++counter[0] == 0)
+                    ++counter[1];
+                index = 0;
+            }
+            uint64_t result = (uint64_t(block[index]) << 32) | block[index + 1];
+            index += 2;
+            return result;
+        }
+
+        /**
+         * @brief Philox4x32-10 bijection of a single counter block under a key.
+         */
+        static void generateBlock(const uint32_t ctr[4], const uint32_t key_[2], uint32_t out[4])
+        {
+            uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+            uint32_t k0 = key_[0], k1 = key_[1];
+            for (int round = 0; round < 10; ++round)
+            {
+                uint64_t p0 = uint64_t(0xD2511F53) * c0;
+                uint64_t p1 = uint64_t(0xCD9E8D57) * c2;
+                uint32_t n0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+                uint32_t n2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+                c1 = uint32_t(p1);
+                c3 = uint32_t(p0);
+                c0 = n0;
+                c2 = n2;
+                k0 += 0x9E3779B9;
+                k1 += 0xBB67AE85;
+            }
+            out[0] = c0;
+            out[1] = c1;
+            out[2] = c2;
+            out[3] = c3;
+        }
+
+    private:
+        uint32_t key[2];
+        uint32_t counter[4];
+        uint32_t block[4];
+        int index = 4;
+    };
+
+    /**
+     * @brief xoshiro256++ (Blackman & Vigna). Satisfies UniformRandomBitGenerator so it can
+     * drive the standard distributions (binomial, poisson, discrete, ...).
+     */
+    class Xoshiro256pp
+    {
+    public:
+        typedef uint64_t result_type;
+
+        explicit Xoshiro256pp(uint64_t seed_ = DEFAULT_SEED) { seed(seed_); }
+
+        void seed(uint64_t seed_)
+        {
+            uint64_t sm = seed_;
+            for (auto &word : s)
+                word = splitmix64(sm);
+        }
+
+        // Takes the state from another generator (e.g. a Philox stream)
+        void seed(Philox4x32 &source)
+        {
+            for (auto &word : s)
+                word = source();
+        }
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+        result_type operator()()
+        {
+            const uint64_t result = rotl(s[0] + s[3], 23) + s[0];
+            const uint64_t t = s[1] << 17;
+            s[2] ^= s[0];
+            s[3] ^= s[1];
+            s[1] ^= s[2];
+            s[0] ^= s[3];
+            s[2] ^= t;
+            s[3] = rotl(s[3], 45);
+            return result;
+        }
+
+    private:
+        uint64_t s[4];
+    };
+
+    /**
+     * @brief Block buffer of uniform doubles in [0, 1).
+     * The buffer is refilled by LANES independent xoshiro256++ generators whose states are stored
+     * lane-by-lane, so the inner loop has no dependencies between lanes and is vectorized by the
+     * compiler. Each 64-bit output is turned into a double by writing its top 52 bits into the
+     * mantissa of a number in [1, 2) and subtracting 1.
+     */
+    class UniformBuffer
+    {
+    public:
+        static constexpr size_t LANES = 4;
+        static constexpr size_t BLOCK_SIZE = 1024;
+
+        explicit UniformBuffer(uint64_t seed_ = DEFAULT_SEED) { seed(seed_); }
+
+        void seed(uint64_t seed_)
+        {
+            uint64_t sm = seed_;
+            for (size_t word = 0; word < 4; ++word)
+                for (size_t lane = 0; lane < LANES; ++lane)
+                    s[word][lane] = splitmix64(sm);
+            position = BLOCK_SIZE;
+        }
+
+        void seed(Philox4x32 &source)
+        {
+            for (size_t word = 0; word < 4; ++word)
+                for (size_t lane = 0; lane < LANES; ++lane)
+                    s[word][lane] = source();
+            position = BLOCK_SIZE;
+        }
+
+        double next()
+        {
+            if (position == BLOCK_SIZE)
+                refill();
+            return buffer[position++];
+        }
+
+    private:
+        alignas(32) uint64_t s[4][LANES];
+        alignas(32) uint64_t bits[BLOCK_SIZE];
+        alignas(32) double buffer[BLOCK_SIZE];
+        size_t position = BLOCK_SIZE;
+
+        void refill()
+        {
+            for (size_t i = 0; i < BLOCK_SIZE; i += LANES)
+            {
+                for (size_t lane = 0; lane < LANES; ++lane)
+                {
+                    const uint64_t result = rotl(s[0][lane] + s[3][lane], 23) + s[0][lane];
+                    const uint64_t t = s[1][lane] << 17;
+                    s[2][lane] ^= s[0][lane];
+                    s[3][lane] ^= s[1][lane];
+                    s[1][lane] ^= s[2][lane];
+                    s[0][lane] ^= s[3][lane];
+                    s[2][lane] ^= t;
+                    s[3][lane] = rotl(s[3][lane], 45);
+                    bits[i + lane] = (result >> 12) | 0x3ff0000000000000ULL;
+                }
+            }
+            std::memcpy(buffer, bits, sizeof(buffer));
+            for (size_t i = 0; i < BLOCK_SIZE; ++i)
+                buffer[i] -= 1.0;
+            position = 0;
+        }
+    };
+
+    // Stream IDs of the generators seeded from the (seed, replica) key
+    inline constexpr uint32_t UNIFORM_STREAM = 0;
+    inline constexpr uint32_t DISTRIBUTION_STREAM = 1;
+    inline constexpr uint32_t FIRST_FREE_STREAM = 2; // Streams >= this are free for workers
+
+    inline const std::string GENERATOR_NAME = "philox4x32-10 -> xoshiro256++";
+
+    // One instance per program (not per translation unit)
+    inline Xoshiro256pp rng(~DEFAULT_SEED);
+    inline UniformBuffer uniforms(DEFAULT_SEED);
+    inline uint64_t currentSeed = DEFAULT_SEED;
+    inline uint32_t currentReplica = 0;
+
+    /**
+     * @brief Uniform random number in [0, 1).
+     */
+    inline double uniform() { return uniforms.next(); }
+
+    /**
+     * @brief Independent, reproducible stream for the current (seed, replica) key.
+     */
+    inline Philox4x32 makeStream(uint32_t stream)
+    {
+        return Philox4x32(currentSeed, currentReplica, stream);
+    }
+
+    /**
+     * @brief Reseeds all generators. The buffered uniforms and the generator used by the standard
+     * distributions are seeded from their own Philox streams of the (seed, replica) key, so
+     * replicas with the same seed are statistically independent.
+     */
+    inline void seed(uint64_t seed_, uint32_t replica = 0)
+    {
+        currentSeed = seed_;
+        currentReplica = replica;
+
+        Philox4x32 uniformStream = makeStream(UNIFORM_STREAM);
+        uniforms.seed(uniformStream);
+        Philox4x32 distributionStream = makeStream(DISTRIBUTION_STREAM);
+        rng.seed(distributionStream);
+    }
+}
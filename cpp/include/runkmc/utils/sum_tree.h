@@ -0,0 +1,79 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+
+/**
+ * @brief Binary sum tree over a fixed number of non-negative weights.
+ * Updating a single weight and sampling an index proportionally to its
+ * weight both cost O(log n). Internal nodes are recomputed from their
+ * children on every update, so no error accumulates in the partial sums.
+ */
+template <typename T>
+class SumTree
+{
+public:
+    SumTree() {};
+    SumTree(size_t size_) { resize(size_); }
+
+    void resize(size_t size_)
+    {
+        size = size_;
+        capacity = 1;
+        while (capacity < size)
+            capacity <<= 1;
+        nodes.assign(2 * capacity, T(0));
+    }
+
+    /**
+     * @brief Rebuilds the full tree from a vector of weights in O(n).
+     */
+    void build(const std::vector<T> &weights)
+    {
+        if (weights.size() != size)
+            resize(weights.size());
+        std::fill(nodes.begin(), nodes.end(), T(0));
+        for (size_t i = 0; i < size; ++i)
+            nodes[capacity + i] = weights[i];
+        for (size_t node = capacity - 1; node > 0; --node)
+            nodes[node] = nodes[2 * node] + nodes[2 * node + 1];
+    }
+
+    void update(size_t index, T weight)
+    {
+        size_t node = capacity + index;
+        nodes[node] = weight;
+        for (node >>= 1; node > 0; node >>= 1)
+            nodes[node] = nodes[2 * node] + nodes[2 * node + 1];
+    }
+
+    /**
+     * @brief Finds the index whose cumulative weight interval contains target,
+     * where 0 <= target < total(). Never returns an index with zero weight
+     * while total() > 0, even if target is pushed past the end by rounding.
+     */
+    size_t find(T target) const
+    {
+        size_t node = 1;
+        while (node < capacity)
+        {
+            size_t left = 2 * node;
+            if (target < nodes[left] || nodes[left + 1] == T(0))
+                node = left;
+            else
+            {
+                target -= nodes[left];
+                node = left + 1;
+            }
+        }
+        return node - capacity;
+    }
+
+    T get(size_t index) const { return nodes[capacity + index]; }
+    T total() const { return nodes[1]; }
+    size_t getSize() const { return size; }
+
+private:
+    size_t size = 0;
+    size_t capacity = 1;
+    std::vector<T> nodes = std::vector<T>(2, T(0));
+};
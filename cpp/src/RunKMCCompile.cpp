@@ -0,0 +1,25 @@
+#include "kmc/builder.h"
+#include "compiler/model_compiler.h"
+
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <inputFilePath> <outputSourcePath>\n";
+        exit(EXIT_FAILURE);
+    }
+
+    std::string inputFilepath = argv[1];
+    std::string outputFilepath = argv[2];
+
+    auto model = KMCBuilder::buildModelComponents(inputFilepath);
+
+    std::string source = model_compiler::generateSource(inputFilepath, model);
+
+    std::ofstream outputFile(outputFilepath);
+    if (!outputFile.is_open())
+        console::error("Cannot write compiled model to " + outputFilepath);
+    outputFile << source;
+
+    return EXIT_SUCCESS;
+}